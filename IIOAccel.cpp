@@ -15,26 +15,54 @@ volatile bool IIOAccel::sigIntReceived = false;
 
 IIOAccel::IIOAccel(QObject *parent) : MainClass(parent)
 {
+    m_sim = NULL;
+
+    //  log from a background thread so that the acquisition thread never waits on the console
+
+    RTeLog::setOutput("stderr");
+    RTeLog::setLevel("debug");
+    RTeLog::startAsync();
 }
 
 void IIOAccel::setup()
 {
     registerSigHandler();
     m_lastTimestamp = 0;
+
+    //  IIOACCEL_SIM_ROOT runs against a simulated device instead of the hardware
+
+    QString simRoot = qgetenv("IIOACCEL_SIM_ROOT");
+
+    if (!simRoot.isEmpty()) {
+        m_sim = new RTeIIOSim();
+        m_sim->setModuleName("sim");
+        m_sim->setDeviceRoot(simRoot);
+        m_sim->resumeThread();
+        m_accel->setDeviceRoot(simRoot);
+    }
 }
 
 void IIOAccel::loop()
 {
     RTeModule *module;
-    RTeSensorAccelData accelData;
+    int last;
 
-    if (newAccelSample_getLastOnly(module, accelData)) {
-        qDebug() << qPrintable(accelData.m_accel.display("Accel:")) << ", " << accelData.m_timestamp - m_lastTimestamp << "uS";
-        m_lastTimestamp = accelData.m_timestamp;
+    if (newAccelSampleBatch_getLastOnly(module, m_batch) && (m_batch.m_count > 0)) {
+        last = m_batch.m_count - 1;
+        RTeVector3 accel(m_batch.m_x[last], m_batch.m_y[last], m_batch.m_z[last]);
+        qDebug() << qPrintable(accel.display("Accel:")) << ", " << (m_batch.m_timestampNs[last] - m_lastTimestamp) / 1000 << "uS";
+        m_lastTimestamp = m_batch.m_timestampNs[last];
     }
 
-    if (IIOAccel::sigIntReceived)
+    if (IIOAccel::sigIntReceived) {
+        if (m_newAccelSampleBatchSlotQueue.overflows() > 0)
+            RTeInfo("main", QString("Batches dropped by the main loop queue: %1").arg(m_newAccelSampleBatchSlotQueue.overflows()));
+        if (m_newAccelSampleBatchSlotQueue.latency().count() > 0)
+            RTeInfo("main", m_newAccelSampleBatchSlotQueue.latency().display());
+        if (m_sim != NULL)
+            m_sim->exitThread();
         quit();
+    }
 }
 
 void IIOAccel::registerSigHandler()
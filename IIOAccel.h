@@ -10,6 +10,7 @@
 #define _IIOACCEL_H
 
 #include "MainClass.h"
+#include "RTeIIOSim.h"
 
 class IIOAccel : public MainClass
 {
@@ -32,6 +33,8 @@ private:
     static volatile bool sigIntReceived;
 
     qint64 m_lastTimestamp;
+    RTeSensorAccelBatch m_batch;                            // the latest batch from the accel
+    RTeIIOSim *m_sim;
 };
 
 #endif // _IIOACCEL_H
@@ -19,3 +19,5 @@ include(IIOAccel.pri)
 include(RTeCore/RTeCore.pri)
 include(RTeModules/RTeIIO/RTeIIOAccel/RTeIIOAccel.pri)
 include(RTeModules/RTeIIO/RTeIIO/RTeIIO.pri)
+include(RTeModules/RTeIIO/RTeIIOSim/RTeIIOSim.pri)
+include(RTeModules/RTeIIO/RTeIIOReplay/RTeIIOReplay.pri)
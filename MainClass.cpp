@@ -7,11 +7,14 @@
 //-----------------------------------------------------------
 
 #include "MainClass.h"
+#include "RTeExecutor.h"
 #include <qthread.h>
 #include <unistd.h>
 
 MainClass::MainClass(QObject *parent) : QObject(parent)
 {
+    m_newAccelSampleBatchSlotQueue.setNotifier(&m_notifier);
+    m_newAccelSampleBatchSlotQueue.setLatencyName("newAccelSampleBatch put to get");
 }
 
 void MainClass::run()
@@ -20,50 +23,61 @@ void MainClass::run()
     m_accel = new RTeIIOAccel();
     m_accel->setModuleName("accel");
     m_accel->setSampleRate("2");
+    m_accel->setSchedPolicy("other");
+    m_accel->setSchedPriority("0");
+    m_accel->setCpuAffinity("");
+    m_accel->setLockMemory("false");
+    m_accel->setMeasureLatency("false");
+    m_newAccelSampleBatchSlotQueue.setType("latest");
+    m_newAccelSampleBatchSlotQueue.setCapacity("1024");
+    m_newAccelSampleBatchSlotQueue.setMemoryLimit("262144");
+    m_newAccelSampleBatchSlotQueue.setPolicy("dropNewest");
+    m_newAccelSampleBatchSlotQueue.setBlockTimeout("100");
+    m_newAccelSampleBatchSlotQueue.setMeasureLatency("false");
     setup();
-    connect(m_accel, SIGNAL(newAccelSample(RTeModule *,RTeSensorAccelData *)), this, SLOT(newAccelSample_put(RTeModule *, RTeSensorAccelData *)), Qt::DirectConnection);
+    connect(m_accel, SIGNAL(newAccelSampleBatch(RTeModule *,RTeSensorAccelBatch *)), this, SLOT(newAccelSampleBatch_put(RTeModule *, RTeSensorAccelBatch *)), Qt::DirectConnection);
     m_accel->resumeThread();
     m_running = true;
     while(m_running) {;
         loop();
-        usleep(10000);
+        m_notifier.wait(RTENOTIFIER_IDLE_WAIT);
     }
     m_accel->exitThread();
     usleep(10000);
+    RTeExecutor::instance()->shutdown();
+    RTeLog::stopAsync();
     emit finished();
 }
 
 void MainClass::quit()
 {
     m_running = false;
+    m_notifier.wake();
 }
 
 void MainClass::aboutToQuit()
 {
 }
 
-void MainClass::newAccelSample_put(RTeModule *module, RTeSensorAccelData *userParameter){
-    QMutexLocker lock(&m_newAccelSampleSlotQueueMutex);
-    newAccelSampleSlotClass data;
-    data.m_module = module;
-    data.m_parameter = *userParameter;
-    m_newAccelSampleSlotQueue.append(data);
+void MainClass::newAccelSampleBatch_put(RTeModule *module, RTeSensorAccelBatch *userParameter){
+    newAccelSampleBatchSlotClass *data = m_newAccelSampleBatchSlotQueue.beginPut();
+    if (data == NULL) return;
+    data->m_module = module;
+    data->m_parameter = *userParameter;
+    m_newAccelSampleBatchSlotQueue.endPut();
 }
 
-bool MainClass::newAccelSample_get(RTeModule* &module, RTeSensorAccelData& userParameter){
-    QMutexLocker lock(&m_newAccelSampleSlotQueueMutex);
-    if (m_newAccelSampleSlotQueue.empty()) return false;
-    newAccelSampleSlotClass data = m_newAccelSampleSlotQueue.dequeue();
+bool MainClass::newAccelSampleBatch_get(RTeModule* &module, RTeSensorAccelBatch& userParameter){
+    newAccelSampleBatchSlotClass data;
+    if (!m_newAccelSampleBatchSlotQueue.get(data)) return false;
     module = data.m_module;
     userParameter = data.m_parameter;
     return true;
 }
 
-bool MainClass::newAccelSample_getLastOnly(RTeModule* &module, RTeSensorAccelData& userParameter){
-    QMutexLocker lock(&m_newAccelSampleSlotQueueMutex);
-    if (m_newAccelSampleSlotQueue.empty()) return false;
-    newAccelSampleSlotClass data = m_newAccelSampleSlotQueue.takeLast();
-    m_newAccelSampleSlotQueue.clear();
+bool MainClass::newAccelSampleBatch_getLastOnly(RTeModule* &module, RTeSensorAccelBatch& userParameter){
+    newAccelSampleBatchSlotClass data;
+    if (!m_newAccelSampleBatchSlotQueue.getLastOnly(data)) return false;
     module = data.m_module;
     userParameter = data.m_parameter;
     return true;
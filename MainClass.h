@@ -10,17 +10,17 @@
 #define _MAINCLASS_H
 
 #include <qobject.h>
-#include <qmutex.h>
-#include <qqueue.h>
 #include "RTeModule.h"
+#include "RTeSlotQueue.h"
+#include "RTeNotifier.h"
 
 #include "RTeIIOAccel.h"
 
-class newAccelSampleSlotClass
+class newAccelSampleBatchSlotClass
 {
 public:
     RTeModule *m_module;
-    RTeSensorAccelData m_parameter;
+    RTeSensorAccelBatch m_parameter;
 };
 
 
@@ -35,9 +35,9 @@ public:
 public slots:
     void run();
     void aboutToQuit();
-    bool newAccelSample_get(RTeModule* &, RTeSensorAccelData &);
-    bool newAccelSample_getLastOnly(RTeModule* &, RTeSensorAccelData &);
-    void newAccelSample_put(RTeModule *, RTeSensorAccelData *);
+    bool newAccelSampleBatch_get(RTeModule* &, RTeSensorAccelBatch &);
+    bool newAccelSampleBatch_getLastOnly(RTeModule* &, RTeSensorAccelBatch &);
+    void newAccelSampleBatch_put(RTeModule *, RTeSensorAccelBatch *);
 
 signals:
     void finished();
@@ -48,10 +48,10 @@ protected:
 
     RTeIIOAccel *m_accel;
 
-private:
-   QQueue<newAccelSampleSlotClass> m_newAccelSampleSlotQueue;
-   QMutex m_newAccelSampleSlotQueueMutex;
+    RTeSlotQueue<newAccelSampleBatchSlotClass> m_newAccelSampleBatchSlotQueue;
+    RTeNotifier m_notifier;
 
+private:
     bool m_running;
 };
 
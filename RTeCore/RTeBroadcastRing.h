@@ -0,0 +1,181 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTEBROADCASTRING_H_
+#define _RTEBROADCASTRING_H_
+
+#include <qglobal.h>
+
+//  RTeBroadcastRing passes items from one writer thread to any number of
+//  readers. Each reader has its own RTeBroadcastReader with a cursor, so
+//  readers go at their own pace and the writer does the same work however
+//  many there are. The writer never waits - a reader that falls more than the
+//  capacity behind loses the oldest items and is told how many in overruns().
+//
+//  Every slot has a sequence number that is odd while the writer is filling
+//  it. A reader copies the slot and then checks that the sequence didn't
+//  change and that the slot still holds the position it wanted. T should be
+//  plain data as a reader may copy a slot that is being overwritten.
+
+template <typename T>
+class RTeBroadcastRing
+{
+public:
+    //  capacity is rounded up to a power of two
+
+    RTeBroadcastRing(int capacity = 1024)
+    {
+        for (m_capacity = 1; m_capacity < (quint32)capacity; m_capacity <<= 1)
+            ;
+        m_mask = m_capacity - 1;
+        m_slots = new RTE_BROADCAST_SLOT[m_capacity];
+        for (quint32 i = 0; i < m_capacity; i++) {
+            m_slots[i].m_sequence = 0;
+            m_slots[i].m_position = 0;
+        }
+        m_head = 0;
+    }
+
+    ~RTeBroadcastRing() { delete [] m_slots; }
+
+    //  publish() is only called by the writer
+
+    void publish(const T& item)
+    {
+        RTE_BROADCAST_SLOT& slot = m_slots[m_head & m_mask];
+        quint32 sequence = slot.m_sequence;
+
+        __atomic_store_n(&slot.m_sequence, sequence + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        slot.m_position = m_head;
+        slot.m_item = item;
+        __atomic_store_n(&slot.m_sequence, sequence + 2, __ATOMIC_RELEASE);
+        __atomic_store_n(&m_head, m_head + 1, __ATOMIC_RELEASE);
+    }
+
+    //  head() is the position the next item will be published at
+
+    quint32 head() const { return __atomic_load_n(&m_head, __ATOMIC_ACQUIRE); }
+    int capacity() const { return (int)m_capacity; }
+
+    //  read() copies the item at position if it is still in the ring. It
+    //  returns false if the writer has overwritten it.
+
+    bool read(quint32 position, T& item) const
+    {
+        const RTE_BROADCAST_SLOT& slot = m_slots[position & m_mask];
+        quint32 before, after, slotPosition;
+
+        while (1) {
+            before = __atomic_load_n(&slot.m_sequence, __ATOMIC_ACQUIRE);
+            if (before & 1)
+                continue;                                   // being written
+            slotPosition = slot.m_position;
+            item = slot.m_item;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            after = __atomic_load_n(&slot.m_sequence, __ATOMIC_RELAXED);
+            if (before == after)
+                return slotPosition == position;
+        }
+    }
+
+private:
+    RTeBroadcastRing(const RTeBroadcastRing&);
+    RTeBroadcastRing& operator=(const RTeBroadcastRing&);
+
+    typedef struct
+    {
+        quint32 m_sequence;                                 // odd while being written
+        quint32 m_position;                                 // position of the item in the slot
+        T m_item;
+    } RTE_BROADCAST_SLOT;
+
+    RTE_BROADCAST_SLOT *m_slots;
+    quint32 m_capacity;
+    quint32 m_mask;
+    quint32 m_head;                                         // next position to publish
+};
+
+//  RTeBroadcastReader is one reader's view of a ring. It starts with the next
+//  item published after it was created.
+
+template <typename T>
+class RTeBroadcastReader
+{
+public:
+    RTeBroadcastReader(const RTeBroadcastRing<T> *ring)
+    {
+        m_ring = ring;
+        m_next = ring->head();
+        m_overruns = 0;
+    }
+
+    //  next() gets the next item, skipping anything already overwritten.
+    //  It returns false if there is nothing new.
+
+    bool next(T& item)
+    {
+        quint32 head;
+
+        while (1) {
+            head = m_ring->head();
+            if (head == m_next)
+                return false;
+
+            if ((head - m_next) > (quint32)m_ring->capacity()) {
+                m_overruns += head - m_next - m_ring->capacity();
+                m_next = head - m_ring->capacity();
+            }
+
+            if (m_ring->read(m_next, item)) {
+                m_next++;
+                return true;
+            }
+
+            //  the writer lapped this reader while the slot was being copied
+
+            m_overruns++;
+            m_next++;
+        }
+    }
+
+    //  lag() is the number of items waiting for this reader
+
+    int lag() const
+    {
+        quint32 behind = m_ring->head() - m_next;
+
+        return behind > (quint32)m_ring->capacity() ? m_ring->capacity() : (int)behind;
+    }
+
+    //  overruns() is the number of items this reader missed because it fell too far behind
+
+    qint64 overruns() const { return m_overruns; }
+
+private:
+    const RTeBroadcastRing<T> *m_ring;
+    quint32 m_next;                                         // position of the next item to read
+    qint64 m_overruns;
+};
+
+#endif // _RTEBROADCASTRING_H_
@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RTeClock.h"
+
+//----------------------------------------------------------
+//
+//  The RTeClock class
+
+RTeClock::RTeClock()
+{
+    m_clock = CLOCK_REALTIME;
+    m_clockName = "realtime";
+    m_offset = 0;
+    m_offsetValid = false;
+}
+
+bool RTeClock::setClock(const QString& name)
+{
+    if (name == "realtime")
+        m_clock = CLOCK_REALTIME;
+    else if (name == "monotonic")
+        m_clock = CLOCK_MONOTONIC;
+    else if (name == "monotonic_raw")
+        m_clock = CLOCK_MONOTONIC_RAW;
+    else if (name == "realtime_coarse")
+        m_clock = CLOCK_REALTIME_COARSE;
+    else if (name == "monotonic_coarse")
+        m_clock = CLOCK_MONOTONIC_COARSE;
+#ifdef CLOCK_BOOTTIME
+    else if (name == "boottime")
+        m_clock = CLOCK_BOOTTIME;
+#endif
+#ifdef CLOCK_TAI
+    else if (name == "tai")
+        m_clock = CLOCK_TAI;
+#endif
+    else
+        return false;
+
+    m_clockName = name;
+    m_offsetValid = false;
+    updateOffset();
+    return true;
+}
+
+qint64 RTeClock::currentNSecs(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (qint64)ts.tv_sec * 1000000000 + (qint64)ts.tv_nsec;
+}
+
+//  The realtime clock is read between two reads of the source clock. The
+//  tightest of a few tries gives the best estimate of the offset.
+
+void RTeClock::updateOffset()
+{
+    qint64 before, realtime, after;
+    qint64 bestWidth = -1;
+    qint64 offset = 0;
+
+    if (m_clock == CLOCK_REALTIME) {
+        m_offset = 0;
+        m_offsetValid = true;
+        return;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        before = currentNSecs(m_clock);
+        realtime = currentNSecs(CLOCK_REALTIME);
+        after = currentNSecs(m_clock);
+
+        if ((bestWidth < 0) || ((after - before) < bestWidth)) {
+            bestWidth = after - before;
+            offset = realtime - (before + (after - before) / 2);
+        }
+    }
+
+    //  small changes are slewed so that mapped timestamps stay smooth, a step
+    //  of the realtime clock is followed immediately
+
+    if (!m_offsetValid || (offset - m_offset > RTECLOCK_STEP_THRESHOLD) ||
+            (m_offset - offset > RTECLOCK_STEP_THRESHOLD))
+        m_offset = offset;
+    else
+        m_offset += (offset - m_offset) / RTECLOCK_SLEW_FACTOR;
+    m_offsetValid = true;
+}
+
+//----------------------------------------------------------
+//
+//  The RTeRateEstimator class
+
+RTeRateEstimator::RTeRateEstimator()
+{
+    reset(0);
+}
+
+void RTeRateEstimator::reset(qreal nominalRate)
+{
+    m_nominalRate = nominalRate;
+    m_firstTimestamp = 0;
+    m_lastTimestamp = 0;
+    m_periods = -1;
+}
+
+void RTeRateEstimator::addSamples(const qint64 *timestamps, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if ((m_periods < 0) || (timestamps[i] < m_lastTimestamp)) {
+            //  first sample or the timestamps went backwards - start again
+
+            m_firstTimestamp = timestamps[i];
+            m_periods = 0;
+        } else {
+            m_periods++;
+        }
+        m_lastTimestamp = timestamps[i];
+    }
+}
+
+qreal RTeRateEstimator::rate() const
+{
+    if ((m_periods <= 0) || (m_lastTimestamp <= m_firstTimestamp))
+        return 0;
+    return (qreal)m_periods * 1000000000.0 / (qreal)(m_lastTimestamp - m_firstTimestamp);
+}
+
+qreal RTeRateEstimator::driftPPM() const
+{
+    qreal measured = rate();
+
+    if ((measured == 0) || (m_nominalRate <= 0))
+        return 0;
+    return (measured / m_nominalRate - 1.0) * 1000000.0;
+}
@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTECLOCK_H_
+#define _RTECLOCK_H_
+
+#include <qstring.h>
+#include <time.h>
+
+#define RTECLOCK_STEP_THRESHOLD         1000000             // offset changes above this (nS) are stepped, not slewed
+#define RTECLOCK_SLEW_FACTOR            16                  // smaller changes are filtered by this factor
+
+//  RTeClock maps timestamps taken on one of the kernel clocks (normally
+//  monotonic_raw or boottime) to the epoch while keeping the nS resolution.
+//  updateOffset() should be called regularly so that the offset follows any
+//  adjustment of the realtime clock.
+
+class RTeClock
+{
+public:
+    RTeClock();
+
+    //  setClock() takes the names used by the IIO current_timestamp_clock attribute
+
+    bool setClock(const QString& name);
+    const QString& clockName() const { return m_clockName; }
+    clockid_t clockId() const { return m_clock; }
+
+    //  updateOffset() re-measures the offset between the clock and the epoch
+
+    void updateOffset();
+
+    //  setOffset() fixes the offset, for example to reproduce the mapping used in a recording
+
+    void setOffset(qint64 offset) { m_offset = offset; m_offsetValid = true; }
+    qint64 offset() const { return m_offset; }
+
+    qint64 currentNSecs() const { return currentNSecs(m_clock); }
+    inline qint64 toEpochNSecs(qint64 timestamp) const { return timestamp + m_offset; }
+    inline qint64 toEpochUSecs(qint64 timestamp) const { return (timestamp + m_offset) / 1000; }
+
+    static qint64 currentNSecs(clockid_t clock);
+
+private:
+    clockid_t m_clock;
+    QString m_clockName;
+    qint64 m_offset;                                        // add to a clock timestamp to get nS since epoch
+    bool m_offsetValid;
+};
+
+//  RTeRateEstimator measures the real sample rate from the sample timestamps
+//  so that the drift of the sensor's clock against the host clock is known.
+//  It isn't thread safe - callers that read it from another thread must lock.
+
+class RTeRateEstimator
+{
+public:
+    RTeRateEstimator();
+
+    void reset(qreal nominalRate);
+    void addSamples(const qint64 *timestamps, int count);
+
+    //  addLostPeriods() accounts for samples known to be missing so that they
+    //  don't bias the measured rate
+
+    void addLostPeriods(qint64 periods) { m_periods += periods; }
+
+    qreal nominalRate() const { return m_nominalRate; }
+    qreal rate() const;                                     // measured samples per second or 0 if unknown
+    qreal driftPPM() const;                                 // rate error in parts per million
+
+private:
+    qreal m_nominalRate;
+    qint64 m_firstTimestamp;                                // start of the measurement in nS
+    qint64 m_lastTimestamp;                                 // latest timestamp in nS
+    qint64 m_periods;                                       // sample periods between first and last
+};
+
+#endif // _RTECLOCK_H_
@@ -0,0 +1,431 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RTeConvert.h"
+
+#include <string.h>
+
+#if !defined(RTEMATH_USE_DOUBLE) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define RTECONVERT_X86
+#include <immintrin.h>
+#endif
+
+#if !defined(RTEMATH_USE_DOUBLE) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define RTECONVERT_ARM
+#include <arm_neon.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define RTECONVERT_HOST_BIG_ENDIAN      true
+#else
+#define RTECONVERT_HOST_BIG_ENDIAN      false
+#endif
+
+typedef void (*RTECONVERT_SOA)(const unsigned char *, int, int, bool, int, RTEFLOAT, RTEFLOAT *, RTEFLOAT *, RTEFLOAT *);
+typedef void (*RTECONVERT_AOS)(const unsigned char *, int, int, bool, int, RTEFLOAT, RTEFLOAT *);
+
+//----------------------------------------------------------
+//
+//  Scalar kernels, used for the ends of blocks and as the reference
+
+static inline RTEFLOAT convertValue(const unsigned char *data, bool swap, int shift, RTEFLOAT scale)
+{
+    uint16_t raw;
+
+    memcpy(&raw, data, 2);
+    if (swap)
+        raw = __builtin_bswap16(raw);
+    return (RTEFLOAT)((int16_t)raw >> shift) * scale;
+}
+
+static void soaScalar(const unsigned char *data, int stride, int count, bool bigEndian, int shift,
+                      RTEFLOAT scale, RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z)
+{
+    const bool swap = bigEndian != RTECONVERT_HOST_BIG_ENDIAN;
+
+    for (int i = 0; i < count; i++, data += stride) {
+        x[i] = convertValue(data, swap, shift, scale);
+        y[i] = convertValue(data + 2, swap, shift, scale);
+        z[i] = convertValue(data + 4, swap, shift, scale);
+    }
+}
+
+static void aosScalar(const unsigned char *data, int stride, int count, bool bigEndian, int shift,
+                      RTEFLOAT scale, RTEFLOAT *xyz)
+{
+    const bool swap = bigEndian != RTECONVERT_HOST_BIG_ENDIAN;
+
+    for (int i = 0; i < count; i++, data += stride, xyz += 3) {
+        xyz[0] = convertValue(data, swap, shift, scale);
+        xyz[1] = convertValue(data + 2, swap, shift, scale);
+        xyz[2] = convertValue(data + 4, swap, shift, scale);
+    }
+}
+
+//  gatherScans() copies count triplets into tmp as x, y, z, 0 so that the SIMD
+//  kernels can load them without reading past the end of the last one.
+//  order gives the slot each scan goes in.
+
+static inline void gatherScans(const unsigned char *data, int stride, int count, const int *order, uint16_t *tmp)
+{
+    for (int k = 0; k < count; k++, data += stride) {
+        memcpy(tmp + order[k] * 4, data, 6);
+        tmp[order[k] * 4 + 3] = 0;
+    }
+}
+
+static const int inOrder[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+
+#ifdef RTECONVERT_X86
+
+//----------------------------------------------------------
+//
+//  SSE2 kernels (always available on x86_64)
+//
+//  Four scans (x, y, z, pad as 16 bit words) are loaded into two registers and
+//  transposed with two rounds of 16 bit unpacks. Unpacking a register with
+//  itself and shifting right by 16 + shift sign extends each value to 32 bits.
+
+static inline __m128i swapBytes128(__m128i v)
+{
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static inline void loadScans128(const unsigned char *data, int stride, bool swap, __m128i& a, __m128i& b)
+{
+    uint16_t tmp[16] __attribute__((aligned(16)));
+
+    if (stride == 8) {
+        a = _mm_loadu_si128((const __m128i *)data);
+        b = _mm_loadu_si128((const __m128i *)(data + 16));
+    } else {
+        gatherScans(data, stride, 4, inOrder, tmp);
+        a = _mm_load_si128((const __m128i *)tmp);
+        b = _mm_load_si128((const __m128i *)(tmp + 8));
+    }
+    if (swap) {
+        a = swapBytes128(a);
+        b = swapBytes128(b);
+    }
+}
+
+static inline __m128 convert128(__m128i v, __m128i shift, __m128 scale)
+{
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_sra_epi32(v, shift)), scale);
+}
+
+static void soaSSE2(const unsigned char *data, int stride, int count, bool bigEndian, int shift,
+                    RTEFLOAT scale, RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z)
+{
+    const bool swap = bigEndian != RTECONVERT_HOST_BIG_ENDIAN;
+    const __m128i vShift = _mm_cvtsi32_si128(16 + shift);
+    const __m128 vScale = _mm_set1_ps(scale);
+    __m128i a, b, t0, t1, xy, zp;
+    int i;
+
+    for (i = 0; i + 4 <= count; i += 4, data += 4 * stride) {
+        loadScans128(data, stride, swap, a, b);
+        t0 = _mm_unpacklo_epi16(a, b);                      // x0 x2 y0 y2 z0 z2 p0 p2
+        t1 = _mm_unpackhi_epi16(a, b);                      // x1 x3 y1 y3 z1 z3 p1 p3
+        xy = _mm_unpacklo_epi16(t0, t1);                    // x0 x1 x2 x3 y0 y1 y2 y3
+        zp = _mm_unpackhi_epi16(t0, t1);                    // z0 z1 z2 z3 p0 p1 p2 p3
+        _mm_storeu_ps(x + i, convert128(_mm_unpacklo_epi16(xy, xy), vShift, vScale));
+        _mm_storeu_ps(y + i, convert128(_mm_unpackhi_epi16(xy, xy), vShift, vScale));
+        _mm_storeu_ps(z + i, convert128(_mm_unpacklo_epi16(zp, zp), vShift, vScale));
+    }
+    soaScalar(data, stride, count - i, bigEndian, shift, scale, x + i, y + i, z + i);
+}
+
+//  each scan is converted as x, y, z, pad and stored 3 floats after the last
+//  one, so the pad is overwritten by the next scan. The loop stops one scan
+//  early so the last pad never lands past the end of xyz.
+
+static void aosSSE2(const unsigned char *data, int stride, int count, bool bigEndian, int shift,
+                    RTEFLOAT scale, RTEFLOAT *xyz)
+{
+    const bool swap = bigEndian != RTECONVERT_HOST_BIG_ENDIAN;
+    const __m128i vShift = _mm_cvtsi32_si128(16 + shift);
+    const __m128 vScale = _mm_set1_ps(scale);
+    __m128i a, b;
+    int i;
+
+    for (i = 0; i + 4 < count; i += 4, data += 4 * stride, xyz += 12) {
+        loadScans128(data, stride, swap, a, b);
+        _mm_storeu_ps(xyz, convert128(_mm_unpacklo_epi16(a, a), vShift, vScale));
+        _mm_storeu_ps(xyz + 3, convert128(_mm_unpackhi_epi16(a, a), vShift, vScale));
+        _mm_storeu_ps(xyz + 6, convert128(_mm_unpacklo_epi16(b, b), vShift, vScale));
+        _mm_storeu_ps(xyz + 9, convert128(_mm_unpackhi_epi16(b, b), vShift, vScale));
+    }
+    aosScalar(data, stride, count - i, bigEndian, shift, scale, xyz);
+}
+
+//----------------------------------------------------------
+//
+//  AVX2 kernel, the SSE2 one on eight scans at a time. The 256 bit unpacks
+//  work within each 128 bit lane so the scans are loaded as 0 1 4 5 and
+//  2 3 6 7 to come out in order. The AoS case uses the SSE2 kernel.
+
+__attribute__((target("avx2")))
+static inline __m256 convert256(__m256i v, __m128i shift, __m256 scale)
+{
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sra_epi32(v, shift)), scale);
+}
+
+__attribute__((target("avx2")))
+static void soaAVX2(const unsigned char *data, int stride, int count, bool bigEndian, int shift,
+                    RTEFLOAT scale, RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z)
+{
+    static const int laneOrder[8] = {0, 1, 4, 5, 2, 3, 6, 7};
+    const bool swap = bigEndian != RTECONVERT_HOST_BIG_ENDIAN;
+    const __m128i vShift = _mm_cvtsi32_si128(16 + shift);
+    const __m256 vScale = _mm256_set1_ps(scale);
+    uint16_t tmp[32] __attribute__((aligned(32)));
+    __m256i a, b, t0, t1, xy, zp;
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8, data += 8 * stride) {
+        if (stride == 8) {
+            t0 = _mm256_loadu_si256((const __m256i *)data);
+            t1 = _mm256_loadu_si256((const __m256i *)(data + 32));
+            a = _mm256_permute2x128_si256(t0, t1, 0x20);
+            b = _mm256_permute2x128_si256(t0, t1, 0x31);
+        } else {
+            gatherScans(data, stride, 8, laneOrder, tmp);
+            a = _mm256_load_si256((const __m256i *)tmp);
+            b = _mm256_load_si256((const __m256i *)(tmp + 16));
+        }
+        if (swap) {
+            a = _mm256_or_si256(_mm256_slli_epi16(a, 8), _mm256_srli_epi16(a, 8));
+            b = _mm256_or_si256(_mm256_slli_epi16(b, 8), _mm256_srli_epi16(b, 8));
+        }
+        t0 = _mm256_unpacklo_epi16(a, b);
+        t1 = _mm256_unpackhi_epi16(a, b);
+        xy = _mm256_unpacklo_epi16(t0, t1);
+        zp = _mm256_unpackhi_epi16(t0, t1);
+        _mm256_storeu_ps(x + i, convert256(_mm256_unpacklo_epi16(xy, xy), vShift, vScale));
+        _mm256_storeu_ps(y + i, convert256(_mm256_unpackhi_epi16(xy, xy), vShift, vScale));
+        _mm256_storeu_ps(z + i, convert256(_mm256_unpacklo_epi16(zp, zp), vShift, vScale));
+    }
+    soaSSE2(data, stride, count - i, bigEndian, shift, scale, x + i, y + i, z + i);
+}
+
+#endif // RTECONVERT_X86
+
+#ifdef RTECONVERT_ARM
+
+//----------------------------------------------------------
+//
+//  NEON kernels. vld4 deinterleaves eight gathered scans into x, y, z and pad
+//  registers and vst3 interleaves the results for the AoS case.
+
+static inline void loadScansNEON(const unsigned char *data, int stride, bool swap, int shift,
+                                 int16x8_t& x, int16x8_t& y, int16x8_t& z)
+{
+    uint16_t tmp[32] __attribute__((aligned(16)));
+    const int16x8_t vShift = vdupq_n_s16(-shift);
+    uint16x8x4_t v;
+
+    gatherScans(data, stride, 8, inOrder, tmp);
+    v = vld4q_u16(tmp);
+    if (swap) {
+        v.val[0] = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(v.val[0])));
+        v.val[1] = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(v.val[1])));
+        v.val[2] = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(v.val[2])));
+    }
+    x = vshlq_s16(vreinterpretq_s16_u16(v.val[0]), vShift);
+    y = vshlq_s16(vreinterpretq_s16_u16(v.val[1]), vShift);
+    z = vshlq_s16(vreinterpretq_s16_u16(v.val[2]), vShift);
+}
+
+static inline float32x4_t convertLowNEON(int16x8_t v, float scale)
+{
+    return vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale);
+}
+
+static inline float32x4_t convertHighNEON(int16x8_t v, float scale)
+{
+    return vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale);
+}
+
+static void soaNEON(const unsigned char *data, int stride, int count, bool bigEndian, int shift,
+                    RTEFLOAT scale, RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z)
+{
+    const bool swap = bigEndian != RTECONVERT_HOST_BIG_ENDIAN;
+    int16x8_t vx, vy, vz;
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8, data += 8 * stride) {
+        loadScansNEON(data, stride, swap, shift, vx, vy, vz);
+        vst1q_f32(x + i, convertLowNEON(vx, scale));
+        vst1q_f32(x + i + 4, convertHighNEON(vx, scale));
+        vst1q_f32(y + i, convertLowNEON(vy, scale));
+        vst1q_f32(y + i + 4, convertHighNEON(vy, scale));
+        vst1q_f32(z + i, convertLowNEON(vz, scale));
+        vst1q_f32(z + i + 4, convertHighNEON(vz, scale));
+    }
+    soaScalar(data, stride, count - i, bigEndian, shift, scale, x + i, y + i, z + i);
+}
+
+static void aosNEON(const unsigned char *data, int stride, int count, bool bigEndian, int shift,
+                    RTEFLOAT scale, RTEFLOAT *xyz)
+{
+    const bool swap = bigEndian != RTECONVERT_HOST_BIG_ENDIAN;
+    int16x8_t vx, vy, vz;
+    float32x4x3_t out;
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8, data += 8 * stride, xyz += 24) {
+        loadScansNEON(data, stride, swap, shift, vx, vy, vz);
+        out.val[0] = convertLowNEON(vx, scale);
+        out.val[1] = convertLowNEON(vy, scale);
+        out.val[2] = convertLowNEON(vz, scale);
+        vst3q_f32(xyz, out);
+        out.val[0] = convertHighNEON(vx, scale);
+        out.val[1] = convertHighNEON(vy, scale);
+        out.val[2] = convertHighNEON(vz, scale);
+        vst3q_f32(xyz + 12, out);
+    }
+    aosScalar(data, stride, count - i, bigEndian, shift, scale, xyz);
+}
+
+#endif // RTECONVERT_ARM
+
+//----------------------------------------------------------
+//
+//  Dispatch
+
+typedef struct
+{
+    RTECONVERT_SOA soa;
+    RTECONVERT_AOS aos;
+} RTECONVERT_KERNELS;
+
+static const RTECONVERT_KERNELS g_scalarKernels = {soaScalar, aosScalar};
+#ifdef RTECONVERT_X86
+static const RTECONVERT_KERNELS g_sse2Kernels = {soaSSE2, aosSSE2};
+static const RTECONVERT_KERNELS g_avx2Kernels = {soaAVX2, aosSSE2};
+#endif
+#ifdef RTECONVERT_ARM
+static const RTECONVERT_KERNELS g_neonKernels = {soaNEON, aosNEON};
+#endif
+
+static RTECONVERT_KERNEL g_kernel = RTECONVERT_AUTO;        // resolved on first use
+static const RTECONVERT_KERNELS *g_funcs = NULL;            // kernels for g_kernel, NULL until resolved
+
+static const RTECONVERT_KERNELS *kernels(RTECONVERT_KERNEL kernel)
+{
+    switch (kernel) {
+    case RTECONVERT_SCALAR:
+        return &g_scalarKernels;
+
+#ifdef RTECONVERT_X86
+    case RTECONVERT_SSE2:
+        return &g_sse2Kernels;
+
+    case RTECONVERT_AVX2:
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("avx2"))
+            return NULL;
+        return &g_avx2Kernels;
+#endif
+
+#ifdef RTECONVERT_ARM
+    case RTECONVERT_NEON:
+        return &g_neonKernels;
+#endif
+
+    default:
+        return NULL;
+    }
+}
+
+static const RTECONVERT_KERNELS *resolveKernels()
+{
+    static const RTECONVERT_KERNEL preferred[] = {RTECONVERT_AVX2, RTECONVERT_NEON, RTECONVERT_SSE2};
+    RTECONVERT_KERNEL kernel = __atomic_load_n(&g_kernel, __ATOMIC_RELAXED);
+    const RTECONVERT_KERNELS *funcs = NULL;
+
+    if (kernel != RTECONVERT_AUTO)
+        funcs = kernels(kernel);
+
+    if (funcs == NULL) {
+        kernel = RTECONVERT_SCALAR;
+        for (unsigned int i = 0; i < sizeof(preferred) / sizeof(preferred[0]); i++) {
+            if (kernels(preferred[i]) != NULL) {
+                kernel = preferred[i];
+                break;
+            }
+        }
+        funcs = kernels(kernel);
+        __atomic_store_n(&g_kernel, kernel, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&g_funcs, funcs, __ATOMIC_RELEASE);
+    return funcs;
+}
+
+//  The feature checks only run when the cache is empty, i.e. on first use and after setKernel()
+
+static inline const RTECONVERT_KERNELS *currentKernels()
+{
+    const RTECONVERT_KERNELS *funcs = __atomic_load_n(&g_funcs, __ATOMIC_ACQUIRE);
+
+    if (funcs == NULL)
+        funcs = resolveKernels();
+    return funcs;
+}
+
+void RTeConvert::tripletsToSoA(const unsigned char *data, int stride, int count, bool bigEndian, int shift,
+                               RTEFLOAT scale, RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z)
+{
+    currentKernels()->soa(data, stride, count, bigEndian, shift, scale, x, y, z);
+}
+
+void RTeConvert::tripletsToAoS(const unsigned char *data, int stride, int count, bool bigEndian, int shift,
+                               RTEFLOAT scale, RTEFLOAT *xyz)
+{
+    currentKernels()->aos(data, stride, count, bigEndian, shift, scale, xyz);
+}
+
+bool RTeConvert::setKernel(RTECONVERT_KERNEL kernel)
+{
+    if ((kernel != RTECONVERT_AUTO) && (kernels(kernel) == NULL))
+        return false;
+    __atomic_store_n(&g_kernel, kernel, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_funcs, (const RTECONVERT_KERNELS *)NULL, __ATOMIC_RELEASE);
+    return true;
+}
+
+RTECONVERT_KERNEL RTeConvert::kernel()
+{
+    currentKernels();
+    return __atomic_load_n(&g_kernel, __ATOMIC_RELAXED);
+}
+
+const char *RTeConvert::kernelName(RTECONVERT_KERNEL kernel)
+{
+    static const char *names[] = {"auto", "scalar", "SSE2", "AVX2", "NEON"};
+
+    if ((kernel < RTECONVERT_AUTO) || (kernel > RTECONVERT_NEON))
+        return "unknown";
+    return names[kernel];
+}
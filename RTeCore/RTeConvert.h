@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTECONVERT_H_
+#define _RTECONVERT_H_
+
+#include "RTeMath.h"
+
+//  RTeConvert turns blocks of raw signed 16 bit x, y, z triplets into scaled
+//  RTEFLOATs. The triplets start stride bytes apart (6 for packed register
+//  reads, the scan size for IIO buffers) and the values are right shifted
+//  (with sign extension) by shift bits for left justified 12 or 14 bit data.
+//
+//  The SSE2, AVX2 or NEON kernel is chosen the first time a conversion is done,
+//  depending on what the processor supports. They only handle float, so the
+//  scalar one is always used if RTEMATH_USE_DOUBLE is defined.
+
+typedef enum
+{
+    RTECONVERT_AUTO = 0,                                    // fastest the processor supports
+    RTECONVERT_SCALAR,
+    RTECONVERT_SSE2,
+    RTECONVERT_AVX2,
+    RTECONVERT_NEON
+} RTECONVERT_KERNEL;
+
+class RTeConvert
+{
+public:
+    //  tripletsToSoA() writes the x, y and z values to separate arrays
+
+    static void tripletsToSoA(const unsigned char *data, int stride, int count, bool bigEndian, int shift,
+                              RTEFLOAT scale, RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z);
+
+    //  tripletsToAoS() writes x, y, z, x, y, z... to xyz which must hold 3 * count values
+
+    static void tripletsToAoS(const unsigned char *data, int stride, int count, bool bigEndian, int shift,
+                              RTEFLOAT scale, RTEFLOAT *xyz);
+
+    //  setKernel() forces a particular kernel, for example the scalar one to
+    //  check the others against. It returns false if it isn't available.
+
+    static bool setKernel(RTECONVERT_KERNEL kernel);
+    static RTECONVERT_KERNEL kernel();
+    static const char *kernelName(RTECONVERT_KERNEL kernel);
+};
+
+#endif // _RTECONVERT_H_
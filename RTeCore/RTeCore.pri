@@ -24,17 +24,35 @@
 INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
 
+LIBS += -lrt
+
+#  C++11 makes the RTeMathTypes constructors and accessors constexpr (they still build as C++98)
+
+QMAKE_CXXFLAGS += -std=gnu++11
+
 HEADERS += $$PWD/RTeObjectModule.h \
     $$PWD/RTeModule.h \
     $$PWD/RTeThreadedModule.h \
     $$PWD/RTeLog.h \
     $$PWD/RTeMath.h \
+    $$PWD/RTeMathTypes.h \
+    $$PWD/RTeMathBatch.h \
     $$PWD/RTeVideoAudio.h \
     $$PWD/RTeSensorDefs.h \
     $$PWD/RTeI2CDriver.h \
     $$PWD/RTeSPIDriver.h \
     $$PWD/RTeSyntroNetRobotDefs.h \
     $$PWD/RTeFusionDefs.h \
+    $$PWD/RTeClock.h \
+    $$PWD/RTeSPSCQueue.h \
+    $$PWD/RTeMailbox.h \
+    $$PWD/RTeTripleBuffer.h \
+    $$PWD/RTeSlotQueue.h \
+    $$PWD/RTeBroadcastRing.h \
+    $$PWD/RTeNotifier.h \
+    $$PWD/RTeExecutor.h \
+    $$PWD/RTeLatencyHistogram.h \
+    $$PWD/RTeConvert.h \
 
 SOURCES += $$PWD/RTeObjectModule.cpp \
     $$PWD/RTeModule.cpp \
@@ -42,6 +60,12 @@ SOURCES += $$PWD/RTeObjectModule.cpp \
     $$PWD/RTeLog.cpp \
     $$PWD/RTeVideoAudio.cpp \
     $$PWD/RTeMath.cpp \
+    $$PWD/RTeMathBatch.cpp \
     $$PWD/RTeI2CDriver.cpp \
     $$PWD/RTeSPIDriver.cpp \
+    $$PWD/RTeClock.cpp \
+    $$PWD/RTeNotifier.cpp \
+    $$PWD/RTeExecutor.cpp \
+    $$PWD/RTeLatencyHistogram.cpp \
+    $$PWD/RTeConvert.cpp \
 
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RTeExecutor.h"
+#include "RTeLog.h"
+
+RTeExecutor::RTeExecutor()
+{
+    m_threadCount = QThread::idealThreadCount();
+    if (m_threadCount < 1)
+        m_threadCount = 1;
+}
+
+RTeExecutor *RTeExecutor::instance()
+{
+    static RTeExecutor executor;
+
+    return &executor;
+}
+
+void RTeExecutor::setThreadCount(int count)
+{
+    QMutexLocker lock(&m_lock);
+
+    if (m_threads.count() > 0) {
+        RTeWarning("executor", "Thread count can't be changed once the pool is running");
+        return;
+    }
+    m_threadCount = count > 0 ? count : 1;
+}
+
+QThread *RTeExecutor::acquire()
+{
+    QMutexLocker lock(&m_lock);
+    int best = 0;
+
+    if (m_threads.count() == 0) {
+        for (int i = 0; i < m_threadCount; i++) {
+            QThread *thread = new QThread();
+            thread->setObjectName(QString("RTeExecutor%1").arg(i));
+            thread->start();
+            m_threads.append(thread);
+            m_modules.append(0);
+        }
+        RTeDebug("executor", QString("Started %1 pool threads").arg(m_threadCount));
+    }
+
+    for (int i = 1; i < m_threads.count(); i++) {
+        if (m_modules.at(i) < m_modules.at(best))
+            best = i;
+    }
+    m_modules[best]++;
+    return m_threads.at(best);
+}
+
+void RTeExecutor::release(QThread *thread)
+{
+    QMutexLocker lock(&m_lock);
+    int index = m_threads.indexOf(thread);
+
+    if (index >= 0)
+        m_modules[index]--;
+}
+
+void RTeExecutor::shutdown()
+{
+    QMutexLocker lock(&m_lock);
+
+    for (int i = 0; i < m_threads.count(); i++) {
+        if (m_modules.at(i) > 0)
+            RTeWarning("executor", QString("Pool thread %1 still has %2 modules").arg(i).arg(m_modules.at(i)));
+        m_threads.at(i)->quit();
+        m_threads.at(i)->wait();
+        delete m_threads.at(i);
+    }
+    m_threads.clear();
+    m_modules.clear();
+}
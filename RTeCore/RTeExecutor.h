@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTEEXECUTOR_H_
+#define _RTEEXECUTOR_H_
+
+#include <qthread.h>
+#include <qmutex.h>
+#include <qlist.h>
+
+//  RTeExecutor is a fixed pool of threads shared by modules that don't need a
+//  thread of their own. A module that opts in with setUseExecutor("true") is
+//  moved to the pool thread with the fewest modules, so its slots and timers
+//  still run one at a time (it behaves as a strand) and the modules on a
+//  thread are served in turn by its event loop.
+//
+//  Modules that block (for example in poll()) must keep their own thread as
+//  they would hold up every other module on the pool thread.
+
+class RTeExecutor
+{
+public:
+    static RTeExecutor *instance();
+
+    //  setThreadCount() must be called before the first module is added. The
+    //  default is the number of cores.
+
+    void setThreadCount(int count);
+
+    //  acquire() returns the pool thread for a new module and release() is
+    //  called when the module has stopped
+
+    QThread *acquire();
+    void release(QThread *thread);
+
+    //  shutdown() stops the pool threads once all the modules have been released
+
+    void shutdown();
+
+private:
+    RTeExecutor();
+
+    QMutex m_lock;
+    int m_threadCount;
+    QList<QThread *> m_threads;
+    QList<int> m_modules;                                   // modules on each thread
+};
+
+#endif // _RTEEXECUTOR_H_
@@ -93,8 +93,8 @@ bool RTeI2CDriver::deviceRead(unsigned char bus, unsigned char slaveAddr, unsign
 
         if (result < 0) {
             if (strlen(errorMsg) > 0)
-                RTeError(NULL, QString("I2C read error from %1, %2 - %3")
-                         .arg(slaveAddr).arg(regAddr).arg(errorMsg));
+                RTeErrorLimited(NULL, QString("I2C read error from %1, %2 - %3")
+                                .arg(slaveAddr).arg(regAddr).arg(errorMsg));
             return false;
         }
 
@@ -109,8 +109,8 @@ bool RTeI2CDriver::deviceRead(unsigned char bus, unsigned char slaveAddr, unsign
 
     if (total < length) {
         if (strlen(errorMsg) > 0)
-            RTeError(m_logTag, QString("I2C read from %1, %2 failed - %3")
-                     .arg(slaveAddr).arg(regAddr).arg(errorMsg));
+            RTeErrorLimited(m_logTag, QString("I2C read from %1, %2 failed - %3")
+                            .arg(slaveAddr).arg(regAddr).arg(errorMsg));
         return false;
     }
     return true;
@@ -178,11 +178,11 @@ bool RTeI2CDriver::internalDeviceWrite(unsigned char bus, unsigned char slaveAdd
         result = write(m_channels[bus].m_fd, &regAddr, 1);
         if (result < 0) {
             if (strlen(errorMsg) > 0)
-                RTeError(m_logTag, QString("I2C write of regAddr failed - %1").arg(errorMsg));
+                RTeErrorLimited(m_logTag, QString("I2C write of regAddr failed - %1").arg(errorMsg));
             return false;
         } else if (result != 1) {
             if (strlen(errorMsg) > 0)
-                RTeError(m_logTag, QString("I2C write of regAddr failed (nothing written) - %1").arg(errorMsg));
+                RTeErrorLimited(m_logTag, QString("I2C write of regAddr failed (nothing written) - %1").arg(errorMsg));
             return false;
         }
     } else {
@@ -193,12 +193,12 @@ bool RTeI2CDriver::internalDeviceWrite(unsigned char bus, unsigned char slaveAdd
 
         if (result < 0) {
             if (strlen(errorMsg) > 0)
-                RTeError(m_logTag, QString("I2C data write of %1 bytes failed - %2").arg(length).arg(errorMsg));
+                RTeErrorLimited(m_logTag, QString("I2C data write of %1 bytes failed - %2").arg(length).arg(errorMsg));
             return false;
         } else if (result < (int)length) {
             if (strlen(errorMsg) > 0)
-                RTeError(m_logTag, QString("I2C data write of %1 bytes failed, only %2 written - %3")
-                         .arg(length).arg(result).arg(errorMsg));
+                RTeErrorLimited(m_logTag, QString("I2C data write of %1 bytes failed, only %2 written - %3")
+                                .arg(length).arg(result).arg(errorMsg));
             return false;
         }
     }
@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RTeLatencyHistogram.h"
+
+#include <string.h>
+
+RTeLatencyHistogram::RTeLatencyHistogram()
+{
+    reset();
+}
+
+//  reset() is not atomic with respect to record() - samples recorded while it
+//  runs may be lost
+
+void RTeLatencyHistogram::reset()
+{
+    memset(m_buckets, 0, sizeof(m_buckets));
+    __atomic_store_n(&m_count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&m_maxBucket, -1, __ATOMIC_RELAXED);
+}
+
+qint64 RTeLatencyHistogram::bucketLimit(int index)
+{
+    int magnitude;
+
+    if (index < RTELATENCY_SUB_BUCKETS)
+        return index;
+
+    magnitude = index / RTELATENCY_HALF_BUCKETS - 1;
+    return ((qint64)(index - magnitude * RTELATENCY_HALF_BUCKETS + 1) << magnitude) - 1;
+}
+
+qint64 RTeLatencyHistogram::max() const
+{
+    int index = __atomic_load_n(&m_maxBucket, __ATOMIC_RELAXED);
+
+    return index >= 0 ? bucketLimit(index) : 0;
+}
+
+qint64 RTeLatencyHistogram::percentile(qreal percent) const
+{
+    quint32 total = count();
+    quint64 target;
+    quint64 sum = 0;
+
+    if (total == 0)
+        return 0;
+
+    target = (quint64)(((qreal)total * percent) / 100.0 + 0.5);
+    if (target < 1)
+        target = 1;
+
+    for (int i = 0; i < RTELATENCY_BUCKETS; i++) {
+        sum += __atomic_load_n(m_buckets + i, __ATOMIC_RELAXED);
+        if (sum >= target)
+            return bucketLimit(i);
+    }
+    return max();
+}
+
+QString RTeLatencyHistogram::display() const
+{
+    return QString("%1: %2 samples, p50 %3uS, p99 %4uS, p99.9 %5uS, max %6uS").arg(m_name).arg(count())
+            .arg(percentile(50) / 1000.0, 0, 'f', 1).arg(percentile(99) / 1000.0, 0, 'f', 1)
+            .arg(percentile(99.9) / 1000.0, 0, 'f', 1).arg(max() / 1000.0, 0, 'f', 1);
+}
@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTELATENCYHISTOGRAM_H_
+#define _RTELATENCYHISTOGRAM_H_
+
+#include <qglobal.h>
+#include <qstring.h>
+
+#define RTELATENCY_SUB_BITS             6                   // 32 buckets per power of two, about 3% resolution
+#define RTELATENCY_MAX_BITS             40                  // values up to 2^40nS (about 18 minutes)
+#define RTELATENCY_SUB_BUCKETS          (1 << RTELATENCY_SUB_BITS)
+#define RTELATENCY_HALF_BUCKETS         (RTELATENCY_SUB_BUCKETS / 2)
+#define RTELATENCY_BUCKETS              ((RTELATENCY_MAX_BITS - RTELATENCY_SUB_BITS + 2) * RTELATENCY_HALF_BUCKETS)
+
+//  RTeLatencyHistogram records latencies in nS into log-linear buckets, in
+//  the style of an HDR histogram. The relative error is constant over the
+//  whole range and record() is just an index calculation and an atomic add,
+//  so it can be used on every sample. Percentiles can be read at any time
+//  from any thread. The counters are 32 bits so that the atomics don't need
+//  library support on 32 bit ARM, and the max is kept to bucket resolution.
+
+class RTeLatencyHistogram
+{
+public:
+    RTeLatencyHistogram();
+
+    void setName(const QString& name) { m_name = name; }
+    const QString& name() const { return m_name; }
+
+    inline void record(qint64 latency)
+    {
+        int index = bucket(latency);
+        int max = __atomic_load_n(&m_maxBucket, __ATOMIC_RELAXED);
+
+        __atomic_fetch_add(m_buckets + index, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&m_count, 1, __ATOMIC_RELAXED);
+        while ((index > max) &&
+               !__atomic_compare_exchange_n(&m_maxBucket, &max, index, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            ;
+    }
+
+    void reset();
+
+    quint32 count() const { return __atomic_load_n(&m_count, __ATOMIC_RELAXED); }
+    qint64 max() const;
+
+    //  percentile() returns the upper limit of the bucket holding the given
+    //  percentile (0 to 100) in nS
+
+    qint64 percentile(qreal percent) const;
+
+    //  display() gives the count and p50, p99, p99.9 and max in uS
+
+    QString display() const;
+
+private:
+    //  values below RTELATENCY_SUB_BUCKETS have their own buckets, above that
+    //  each power of two is split into RTELATENCY_HALF_BUCKETS buckets
+
+    static inline int bucket(qint64 latency)
+    {
+        int magnitude;
+
+        if (latency < RTELATENCY_SUB_BUCKETS)
+            return latency > 0 ? (int)latency : 0;
+        if (latency >= ((qint64)1 << RTELATENCY_MAX_BITS))
+            return RTELATENCY_BUCKETS - 1;
+
+        magnitude = 63 - __builtin_clzll((quint64)latency) - (RTELATENCY_SUB_BITS - 1);
+        return magnitude * RTELATENCY_HALF_BUCKETS + (int)(latency >> magnitude);
+    }
+
+    static qint64 bucketLimit(int index);
+
+    QString m_name;
+    quint32 m_buckets[RTELATENCY_BUCKETS];
+    quint32 m_count;
+    int m_maxBucket;                                        // highest bucket used, -1 if none
+};
+
+#endif // _RTELATENCYHISTOGRAM_H_
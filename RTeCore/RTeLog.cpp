@@ -22,12 +22,345 @@
 //  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "RTeLog.h"
+#include "RTeClock.h"
+#include "RTeNotifier.h"
+#include "RTeSPSCQueue.h"
+
+#include <qthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <syslog.h>
+#include <pthread.h>
+
+//  each thread that logs gets its own ring so producers never contend. Rings
+//  are only ever added to the list (at the head) so the writer can walk it
+//  without locking. When a thread exits its ring is released and reused by
+//  the next new thread, so the list only grows to the most threads that have
+//  logged at once. Anything left in a released ring is still written out.
+
+class RTeLogRing
+{
+public:
+    RTeLogRing() : m_queue(RTELOG_RING_SIZE), m_next(NULL), m_reported(0), m_inUse(1) {}
+
+    RTeSPSCQueue<RTELOG_RECORD> m_queue;
+    RTeLogRing *m_next;
+    qint64 m_reported;                                      // drops already reported by the writer
+    int m_inUse;                                            // 1 while a thread owns the ring
+};
+
+class RTeLogWriter : public QThread
+{
+public:
+    RTeLogWriter() : m_stop(false) {}
+
+    void stop() { __atomic_store_n(&m_stop, true, __ATOMIC_RELEASE); m_notifier.wake(); }
+    void restart() { __atomic_store_n(&m_stop, false, __ATOMIC_RELEASE); start(); }
+
+    RTeNotifier m_notifier;                                 // woken by addMessage()
+
+protected:
+    void run();
+
+private:
+    bool m_stop;
+};
 
 QMutex RTeLog::m_lock;
+int RTeLog::m_level = RTELOG_DEBUG;
+
+static RTeLogRing *g_rings = NULL;                          // every thread's ring
+static __thread RTeLogRing *g_threadRing = NULL;            // this thread's ring
+static pthread_key_t g_ringKey;                             // releases the ring when the thread exits
+static pthread_once_t g_ringKeyOnce = PTHREAD_ONCE_INIT;
+static RTeLogWriter *g_writer = NULL;                       // never deleted as late loggers may still notify it
+static bool g_async = false;
+static QMutex g_flushLock;                                  // one flush() at a time
+
+static FILE *g_file = NULL;                                 // output file, NULL for stderr or syslog
+static bool g_syslog = false;
+
+//  copyString() truncates to ASCII without allocating
+
+static void copyString(char *dest, int size, const QString& src)
+{
+    const QChar *data = src.unicode();
+    int len = qMin(src.length(), size - 1);
+    ushort c;
+
+    for (int i = 0; i < len; i++) {
+        c = data[i].unicode();
+        dest[i] = ((c >= 0x20) && (c < 0x7f)) ? (char)c : '?';
+    }
+    dest[len] = 0;
+}
+
+static void copyString(char *dest, int size, const char *src)
+{
+    int len;
+
+    for (len = 0; (len < size - 1) && (src[len] != 0); len++)
+        dest[len] = ((src[len] >= 0x20) && (src[len] < 0x7f)) ? src[len] : '?';
+    dest[len] = 0;
+}
+
+//  releaseRing() is called by pthreads when a thread that has a ring exits
+
+static void releaseRing(void *ring)
+{
+    g_threadRing = NULL;
+    __atomic_store_n(&((RTeLogRing *)ring)->m_inUse, 0, __ATOMIC_RELEASE);
+}
 
-void RTeLog::addMessage(const QString& tag, const QString& type, const QString& desc)
+static void createRingKey()
+{
+    pthread_key_create(&g_ringKey, releaseRing);
+}
+
+static RTeLogRing *threadRing()
+{
+    RTeLogRing *ring = g_threadRing;
+    int unused;
+
+    if (ring != NULL)
+        return ring;
+
+    //  reuse a ring released by a thread that has exited
+
+    for (ring = __atomic_load_n(&g_rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->m_next) {
+        unused = 0;
+        if (__atomic_compare_exchange_n(&ring->m_inUse, &unused, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            break;
+    }
+
+    if (ring == NULL) {
+        ring = new RTeLogRing();
+        ring->m_next = __atomic_load_n(&g_rings, __ATOMIC_ACQUIRE);
+        while (!__atomic_compare_exchange_n(&g_rings, &ring->m_next, ring, false, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+            ;
+    }
+
+    pthread_once(&g_ringKeyOnce, createRingKey);
+    pthread_setspecific(g_ringKey, ring);
+    g_threadRing = ring;
+    return ring;
+}
+
+void RTeLog::addMessage(const QString& tag, int level, const QString& desc, int suppressed)
+{
+    RTELOG_RECORD record;
+
+    record.time = RTeClock::currentNSecs(CLOCK_REALTIME);
+    record.level = level;
+    copyString(record.tag, RTELOG_TAG_SIZE, tag);
+    copyString(record.text, RTELOG_TEXT_SIZE, desc);
+    queueRecord(record, suppressed);
+}
+
+void RTeLog::addMessage(const QString& tag, int level, const char *desc, int suppressed)
+{
+    RTELOG_RECORD record;
+
+    record.time = RTeClock::currentNSecs(CLOCK_REALTIME);
+    record.level = level;
+    copyString(record.tag, RTELOG_TAG_SIZE, tag);
+    copyString(record.text, RTELOG_TEXT_SIZE, desc);
+    queueRecord(record, suppressed);
+}
+
+//  queueRecord() adds the suppressed count and writes the record or queues it for the writer
+
+void RTeLog::queueRecord(RTELOG_RECORD& record, int suppressed)
+{
+    int len;
+
+    if (suppressed > 0) {
+        len = strlen(record.text);
+        snprintf(record.text + len, RTELOG_TEXT_SIZE - len, " (%d similar suppressed)", suppressed);
+    }
+
+    if (!__atomic_load_n(&g_async, __ATOMIC_ACQUIRE)) {
+        writeRecord(record);
+        return;
+    }
+
+    if (threadRing()->m_queue.push(record))
+        g_writer->m_notifier.notify();
+
+    //  if stopAsync() was called since g_async was read its final flush may
+    //  have missed this record so write it out here. The fence pairs with the
+    //  one in stopAsync() so that one of the two flushes sees the record.
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&g_async, __ATOMIC_RELAXED))
+        flush();
+}
+
+void RTeLog::setLevel(const QString& level)
+{
+    static const char *names[] = {"debug", "info", "warn", "error", "fatal"};
+
+    for (int i = RTELOG_DEBUG; i <= RTELOG_FATAL; i++) {
+        if (level == names[i]) {
+            setLevel(i);
+            return;
+        }
+    }
+    RTeWarning("RTeLog", QString("Unknown log level ") + level);
+}
+
+bool RTeLog::checkLimit(RTELOG_LIMIT *limit, int *suppressed)
+{
+    quint32 now = (quint32)(RTeClock::currentNSecs(CLOCK_MONOTONIC) / 1000000) | 1;
+    quint32 last = __atomic_load_n(&limit->last, __ATOMIC_RELAXED);
+
+    //  if another thread logs first this one counts as suppressed
+
+    if (((last != 0) && ((now - last) < RTELOG_LIMIT_INTERVAL)) ||
+            !__atomic_compare_exchange_n(&limit->last, &last, now, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        __atomic_fetch_add(&limit->suppressed, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    *suppressed = __atomic_exchange_n(&limit->suppressed, 0, __ATOMIC_RELAXED);
+    return true;
+}
+
+bool RTeLog::setOutput(const QString& output)
 {
     QMutexLocker lock(&m_lock);
 
-    qDebug() << qPrintable(tag + " - " + type + ": " + desc);
+    if (g_file != NULL) {
+        fclose(g_file);
+        g_file = NULL;
+    }
+    if (g_syslog) {
+        closelog();
+        g_syslog = false;
+    }
+
+    if (output.isEmpty() || (output == "stderr"))
+        return true;
+
+    if (output == "syslog") {
+        openlog(NULL, LOG_PID, LOG_USER);
+        g_syslog = true;
+        return true;
+    }
+
+    if ((g_file = fopen(qPrintable(output), "a")) == NULL) {
+        qDebug() << "RTeLog - Error: Failed to open log file" << output;
+        return false;
+    }
+    return true;
+}
+
+void RTeLog::startAsync()
+{
+    if (__atomic_load_n(&g_async, __ATOMIC_ACQUIRE))
+        return;
+
+    if (g_writer == NULL)
+        g_writer = new RTeLogWriter();
+    g_writer->restart();
+    __atomic_store_n(&g_async, true, __ATOMIC_RELEASE);
+}
+
+//  stopAsync() goes back to writing on the calling thread. The writer object
+//  is kept as a thread that read g_async just before it was cleared may still
+//  notify it. Anything such a thread queues after the flush below is written
+//  by that thread itself (see addMessage()).
+
+void RTeLog::stopAsync()
+{
+    if (!__atomic_load_n(&g_async, __ATOMIC_ACQUIRE))
+        return;
+
+    __atomic_store_n(&g_async, false, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    g_writer->stop();
+    g_writer->wait();
+    flush();
+}
+
+void RTeLog::registerThread()
+{
+    threadRing();
+}
+
+qint64 RTeLog::droppedMessages()
+{
+    qint64 dropped = 0;
+
+    for (RTeLogRing *ring = __atomic_load_n(&g_rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->m_next)
+        dropped += ring->m_queue.overflows();
+    return dropped;
+}
+
+const char *RTeLog::levelName(int level)
+{
+    switch (level) {
+    case RTELOG_DEBUG:
+        return "Debug";
+
+    case RTELOG_INFO:
+        return "Info";
+
+    case RTELOG_WARN:
+        return "Warn";
+
+    case RTELOG_ERROR:
+        return "Error";
+
+    default:
+        return "Fatal";
+    }
+}
+
+void RTeLog::writeRecord(const RTELOG_RECORD& record)
+{
+    static const int syslogPriority[] = {LOG_DEBUG, LOG_INFO, LOG_WARNING, LOG_ERR, LOG_CRIT};
+    QMutexLocker lock(&m_lock);
+
+    if (g_syslog) {
+        syslog(syslogPriority[qBound(0, record.level, (int)RTELOG_FATAL)], "%s - %s: %s",
+               record.tag, levelName(record.level), record.text);
+    } else if (g_file != NULL) {
+        fprintf(g_file, "%lld.%06d %s - %s: %s\n", (long long)(record.time / 1000000000),
+                (int)((record.time % 1000000000) / 1000), record.tag, levelName(record.level), record.text);
+        fflush(g_file);
+    } else {
+        fprintf(stderr, "%s - %s: %s\n", record.tag, levelName(record.level), record.text);
+    }
+}
+
+//  flush() writes everything queued. It is called by the writer thread and,
+//  around stopAsync(), by stopAsync() itself and by late loggers.
+
+void RTeLog::flush()
+{
+    QMutexLocker lock(&g_flushLock);
+    RTELOG_RECORD record;
+    qint64 overflows;
+
+    for (RTeLogRing *ring = __atomic_load_n(&g_rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->m_next) {
+        while (ring->m_queue.pop(record))
+            writeRecord(record);
+
+        if ((overflows = ring->m_queue.overflows()) != ring->m_reported) {
+            record.time = RTeClock::currentNSecs(CLOCK_REALTIME);
+            record.level = RTELOG_WARN;
+            copyString(record.tag, RTELOG_TAG_SIZE, "RTeLog");
+            snprintf(record.text, RTELOG_TEXT_SIZE, "%lld messages dropped", (long long)(overflows - ring->m_reported));
+            writeRecord(record);
+            ring->m_reported = overflows;
+        }
+    }
+}
+
+void RTeLogWriter::run()
+{
+    while (!__atomic_load_n(&m_stop, __ATOMIC_ACQUIRE)) {
+        m_notifier.wait(RTELOG_FLUSH_INTERVAL);
+        RTeLog::flush();
+    }
 }
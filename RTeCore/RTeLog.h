@@ -28,23 +28,139 @@
 #include <qmutex.h>
 #include <qstring.h>
 
+typedef enum
+{
+    RTELOG_DEBUG = 0,
+    RTELOG_INFO,
+    RTELOG_WARN,
+    RTELOG_ERROR,
+    RTELOG_FATAL
+} RTELOG_LEVEL;
+
+//  messages below RTELOG_MIN_LEVEL are removed at compile time. It can be set
+//  with -DRTELOG_MIN_LEVEL=n, otherwise QT_NO_DEBUG removes debug messages.
+
+#ifndef RTELOG_MIN_LEVEL
 #ifdef QT_NO_DEBUG
-#define RTeDebug(m, x)
+#define RTELOG_MIN_LEVEL                RTELOG_INFO
 #else
-#define RTeDebug(m, x)                  RTeLog::addMessage(m, "Debug", x)
+#define RTELOG_MIN_LEVEL                RTELOG_DEBUG
 #endif
-#define RTeInfo(m, x)                   RTeLog::addMessage(m, "Info", x)
-#define RTeWarning(m, x)                RTeLog::addMessage(m, "Warn", x)
-#define RTeError(m, x)                  RTeLog::addMessage(m, "Error", x)
-#define RTeFatal(m, x)                  RTeLog::addMessage(m, "Fatal", x)
+#endif
+
+//  RTELOG_ENABLED() is true if a message at level passes both the compile time
+//  and runtime filters. It can be used to skip formatting a const char * message.
+
+#define RTELOG_ENABLED(level)           (((level) >= RTELOG_MIN_LEVEL) && RTeLog::isEnabled(level))
+
+//  the message argument is only evaluated (and its arg() chain only run) if
+//  the level passes both the compile time and runtime filters
+
+#define RTELOG_MESSAGE(m, level, x) \
+    do { \
+        if (RTELOG_ENABLED(level)) \
+            RTeLog::addMessage(m, level, x); \
+    } while (0)
+
+//  a limited message is logged at most once every RTELOG_LIMIT_INTERVAL mS
+//  from each place it's used. The next one logged says how many were suppressed.
+
+#define RTELOG_LIMITED_MESSAGE(m, level, x) \
+    do { \
+        static RTELOG_LIMIT rteLogLimit = {0, 0}; \
+        int rteLogSuppressed; \
+        if (RTELOG_ENABLED(level) && RTeLog::checkLimit(&rteLogLimit, &rteLogSuppressed)) \
+            RTeLog::addMessage(m, level, x, rteLogSuppressed); \
+    } while (0)
+
+#define RTeDebug(m, x)                  RTELOG_MESSAGE(m, RTELOG_DEBUG, x)
+#define RTeInfo(m, x)                   RTELOG_MESSAGE(m, RTELOG_INFO, x)
+#define RTeWarning(m, x)                RTELOG_MESSAGE(m, RTELOG_WARN, x)
+#define RTeError(m, x)                  RTELOG_MESSAGE(m, RTELOG_ERROR, x)
+#define RTeFatal(m, x)                  RTELOG_MESSAGE(m, RTELOG_FATAL, x)
+
+#define RTeWarningLimited(m, x)         RTELOG_LIMITED_MESSAGE(m, RTELOG_WARN, x)
+#define RTeErrorLimited(m, x)           RTELOG_LIMITED_MESSAGE(m, RTELOG_ERROR, x)
+
+#define RTELOG_LIMIT_INTERVAL           1000                // mS between limited messages from one place
+
+typedef struct
+{
+    quint32 last;                                           // mS time of the last message logged, 0 for none
+    quint32 suppressed;                                     // messages suppressed since then
+} RTELOG_LIMIT;
+
+#define RTELOG_TAG_SIZE                 32                  // longest tag kept (including the terminating 0)
+#define RTELOG_TEXT_SIZE                216                 // longest message kept (including the terminating 0)
+#define RTELOG_RING_SIZE                256                 // records queued per thread
+#define RTELOG_FLUSH_INTERVAL           50                  // mS between writes when nothing wakes the writer
+
+//  a message as it is queued for the writer thread
+
+typedef struct
+{
+    qint64 time;                                            // CLOCK_REALTIME nS when the message was logged
+    int level;
+    char tag[RTELOG_TAG_SIZE];
+    char text[RTELOG_TEXT_SIZE];
+} RTELOG_RECORD;
+
+//  By default messages are written on the calling thread. Once startAsync()
+//  has been called addMessage() just copies the message into a ring owned by
+//  the calling thread and a background thread writes it out, so logging never
+//  waits for the console, a file or syslog. If a thread's ring is full the
+//  message is dropped and the writer reports how many were lost.
 
 class RTeLog
 {
 public:
-    static void addMessage(const QString& tag, const QString& type, const QString& desc);
+    static void addMessage(const QString& tag, int level, const QString& desc, int suppressed = 0);
+
+    //  this version takes a literal or text already formatted into a buffer
+    //  (with snprintf() for example) so no QString is built for the message
+
+    static void addMessage(const QString& tag, int level, const char *desc, int suppressed = 0);
+
+    //  setLevel() sets the lowest level logged at runtime, as an RTELOG_LEVEL or
+    //  "debug", "info", "warn", "error" or "fatal"
+
+    static void setLevel(int level) { __atomic_store_n(&m_level, level, __ATOMIC_RELAXED); }
+    static void setLevel(const QString& level);
+    static inline bool isEnabled(int level) { return level >= __atomic_load_n(&m_level, __ATOMIC_RELAXED); }
+
+    //  checkLimit() is used by the limited macros. It returns true if the
+    //  message should be logged and sets suppressed to the number skipped.
+
+    static bool checkLimit(RTELOG_LIMIT *limit, int *suppressed);
+
+    //  setOutput() takes "stderr" (the default), "syslog" or a file name to append to
+
+    static bool setOutput(const QString& output);
+
+    //  stopAsync() writes anything still queued. Messages from threads that
+    //  are still running are then written on the calling thread again.
+
+    static void startAsync();
+    static void stopAsync();
+
+    //  registerThread() creates the calling thread's ring so that its first
+    //  message doesn't have to allocate one. The ring is released for reuse
+    //  when the thread exits.
+
+    static void registerThread();
+
+    static qint64 droppedMessages();
+    static const char *levelName(int level);
 
 private:
+    static void queueRecord(RTELOG_RECORD& record, int suppressed);
+    static void writeRecord(const RTELOG_RECORD& record);
+    static void flush();
+
     static QMutex m_lock;
+    static int m_level;                                     // lowest level logged
+
+    friend class RTeLogWriter;
 };
 
 #endif // RTELOG_H
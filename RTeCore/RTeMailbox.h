@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTEMAILBOX_H_
+#define _RTEMAILBOX_H_
+
+#include <qglobal.h>
+
+#define RTEMAILBOX_MAX_SIZE             128                 // largest item a reader should spin on
+
+//  RTeMailbox holds the latest value from one writer thread for readers that
+//  only want the current state, such as displays. It is a seqlock - put()
+//  never waits and a reader copies the value again if a put() overlapped it.
+//  T must be plain data and small as a reader may copy it more than once.
+//  Use RTeTripleBuffer for larger items.
+
+template <typename T>
+class RTeMailbox
+{
+    static_assert(sizeof(T) <= RTEMAILBOX_MAX_SIZE, "RTeMailbox items must be small, use RTeTripleBuffer");
+
+public:
+    RTeMailbox() { m_sequence = 0; m_lastRead = 0; }
+
+    //  put() is only called by the writer
+
+    void put(const T& item)
+    {
+        *beginPut() = item;
+        endPut();
+    }
+
+    //  beginPut() returns the value for the writer to fill in place. Readers
+    //  retry until endPut() is called so keep the gap between them short.
+
+    T *beginPut()
+    {
+        __atomic_store_n(&m_sequence, m_sequence + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        return &m_item;
+    }
+
+    void endPut() { __atomic_store_n(&m_sequence, m_sequence + 1, __ATOMIC_RELEASE); }
+
+    //  get() returns the latest value. It returns false if nothing has been put yet.
+
+    bool get(T& item) const
+    {
+        quint32 sequence;
+
+        return read(item, sequence);
+    }
+
+    //  getIfNew() only returns a value that hasn't been returned by getIfNew()
+    //  before. It is for a single reader.
+
+    bool getIfNew(T& item)
+    {
+        quint32 sequence;
+
+        if (__atomic_load_n(&m_sequence, __ATOMIC_ACQUIRE) == m_lastRead)
+            return false;
+        if (!read(item, sequence) || (sequence == m_lastRead))
+            return false;
+        m_lastRead = sequence;
+        return true;
+    }
+
+    //  puts() is the number of values written
+
+    quint32 puts() const { return __atomic_load_n(&m_sequence, __ATOMIC_RELAXED) / 2; }
+
+private:
+    bool read(T& item, quint32& sequence) const
+    {
+        quint32 after;
+
+        while (1) {
+            sequence = __atomic_load_n(&m_sequence, __ATOMIC_ACQUIRE);
+            if (sequence & 1)
+                continue;                                   // a put() is in progress
+            item = m_item;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            after = __atomic_load_n(&m_sequence, __ATOMIC_RELAXED);
+            if (after == sequence)
+                return sequence != 0;
+        }
+    }
+
+    T m_item;
+    quint32 m_sequence;                                     // odd while a put() is in progress
+    quint32 m_lastRead;                                     // sequence last returned by getIfNew()
+};
+
+#endif // _RTEMAILBOX_H_
@@ -43,9 +43,11 @@ typedef float RTEFLOAT;
 
 #define RTEMATH_CLOCKS_PER_SEC      1000000
 
-class RTeVector3;
-class RTeMatrix4x4;
-class RTeQuaternion;
+#include "RTeMathTypes.h"
+
+typedef RTeVector3T<RTEFLOAT> RTeVector3;
+typedef RTeQuaternionT<RTEFLOAT> RTeQuaternion;
+typedef RTeMatrix4x4T<RTEFLOAT> RTeMatrix4x4;
 
 class RTeMath
 {
@@ -66,7 +68,8 @@ public:
 
     static RTeVector3 poseFromAccelMag(const RTeVector3& accel, const RTeVector3& mag);
 
-    //  Takes signed 16 bit data from a char array and converts it to a vector of scaled RTEFLOATs
+    //  Takes signed 16 bit data from a char array and converts it to a vector of scaled RTEFLOATs.
+    //  RTeConvert does the same for whole blocks of samples.
 
     static void convertToVector(unsigned char *rawData, RTeVector3& vec, RTEFLOAT scale, bool bigEndian);
 
@@ -79,116 +82,4 @@ private:
 };
 
 
-class RTeVector3
-{
-public:
-    RTeVector3();
-    RTeVector3(RTEFLOAT x, RTEFLOAT y, RTEFLOAT z);
-
-    const RTeVector3&  operator +=(RTeVector3& vec);
-    const RTeVector3&  operator -=(RTeVector3& vec);
-
-    RTeVector3& operator =(const RTeVector3& vec);
-
-    RTEFLOAT length();
-    void normalize();
-    void zero();
-    bool isZero();
-    QString display(const QString &label);
-
-    static float dotProduct(const RTeVector3& a, const RTeVector3& b);
-    static void crossProduct(const RTeVector3& a, const RTeVector3& b, RTeVector3& d);
-
-    void accelToEuler(RTeVector3& rollPitchYaw) const;
-    void accelToQuaternion(RTeQuaternion& qPose) const;
-
-    inline RTEFLOAT x() const { return m_data[0]; }
-    inline RTEFLOAT y() const { return m_data[1]; }
-    inline RTEFLOAT z() const { return m_data[2]; }
-    inline RTEFLOAT data(const int i) const { return m_data[i]; }
-
-    inline void setX(const RTEFLOAT val) { m_data[0] = val; }
-    inline void setY(const RTEFLOAT val) { m_data[1] = val; }
-    inline void setZ(const RTEFLOAT val) { m_data[2] = val; }
-    inline void setData(const int i, RTEFLOAT val) { m_data[i] = val; }
-
-private:
-    RTEFLOAT m_data[3];
-};
-
-
-class RTeQuaternion
-{
-public:
-    RTeQuaternion();
-    RTeQuaternion(RTEFLOAT scalar, RTEFLOAT x, RTEFLOAT y, RTEFLOAT z);
-
-    RTeQuaternion& operator +=(const RTeQuaternion& quat);
-    RTeQuaternion& operator -=(const RTeQuaternion& quat);
-    RTeQuaternion& operator *=(const RTeQuaternion& qb);
-    RTeQuaternion& operator *=(const RTEFLOAT val);
-    RTeQuaternion& operator -=(const RTEFLOAT val);
-
-    RTeQuaternion& operator =(const RTeQuaternion& quat);
-    const RTeQuaternion operator *(const RTeQuaternion& qb) const;
-    const RTeQuaternion operator *(const RTEFLOAT val) const;
-    const RTeQuaternion operator -(const RTeQuaternion& qb) const;
-    const RTeQuaternion operator -(const RTEFLOAT val) const;
-
-    void normalize();
-    void toEuler(RTeVector3& vec);
-    void fromEuler(RTeVector3& vec);
-    RTeQuaternion conjugate() const;
-    void toAngleVector(RTEFLOAT& angle, RTeVector3& vec);
-    void fromAngleVector(const RTEFLOAT& angle, const RTeVector3& vec);
-
-    void zero();
-    const char *display();
-
-    inline RTEFLOAT scalar() const { return m_data[0]; }
-    inline RTEFLOAT x() const { return m_data[1]; }
-    inline RTEFLOAT y() const { return m_data[2]; }
-    inline RTEFLOAT z() const { return m_data[3]; }
-    inline RTEFLOAT data(const int i) const { return m_data[i]; }
-
-    inline void setScalar(const RTEFLOAT val) { m_data[0] = val; }
-    inline void setX(const RTEFLOAT val) { m_data[1] = val; }
-    inline void setY(const RTEFLOAT val) { m_data[2] = val; }
-    inline void setZ(const RTEFLOAT val) { m_data[3] = val; }
-    inline void setData(const int i, RTEFLOAT val) { m_data[i] = val; }
-
-private:
-    RTEFLOAT m_data[4];
-};
-
-class RTeMatrix4x4
-{
-public:
-    RTeMatrix4x4();
-
-    RTeMatrix4x4& operator +=(const RTeMatrix4x4& mat);
-    RTeMatrix4x4& operator -=(const RTeMatrix4x4& mat);
-    RTeMatrix4x4& operator *=(const RTEFLOAT val);
-
-    RTeMatrix4x4& operator =(const RTeMatrix4x4& vec);
-    const RTeQuaternion operator *(const RTeQuaternion& q) const;
-    const RTeMatrix4x4 operator *(const RTEFLOAT val) const;
-    const RTeMatrix4x4 operator *(const RTeMatrix4x4& mat) const;
-    const RTeMatrix4x4 operator +(const RTeMatrix4x4& mat) const;
-
-    inline RTEFLOAT val(int row, int col) const { return m_data[row][col]; }
-    inline void setVal(int row, int col, RTEFLOAT val) { m_data[row][col] = val; }
-    void fill(RTEFLOAT val);
-    void setToIdentity();
-
-    RTeMatrix4x4 inverted();
-    RTeMatrix4x4 transposed();
-
-private:
-    RTEFLOAT m_data[4][4];                                   // row, column
-
-    RTEFLOAT matDet();
-    RTEFLOAT matMinor(const int row, const int col);
-};
-
 #endif /* _RTEMATH_H_ */
@@ -0,0 +1,526 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RTeMathBatch.h"
+#include "RTeLog.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(RTEMATH_USE_DOUBLE) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define RTEMATHBATCH_SSE2
+#include <emmintrin.h>
+#elif !defined(RTEMATH_USE_DOUBLE) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define RTEMATHBATCH_NEON
+#include <arm_neon.h>
+#endif
+
+#define RTEMATHBATCH_SLERP_LINEAR       0.9995              // above this cos(angle) slerp just interpolates
+
+static bool g_useSIMD = true;
+
+//  resizeArrays() reallocates the component arrays of an SoA container as one
+//  block with each array aligned, copying the values that still fit
+
+static bool resizeArrays(RTEFLOAT **data, int arrays, int count, int oldCount, int& capacity)
+{
+    const int perBlock = RTEMATHBATCH_ALIGN / sizeof(RTEFLOAT);
+    int newCapacity = (count + perBlock - 1) / perBlock * perBlock;
+    void *block;
+
+    if (count <= capacity)
+        return true;
+
+    if (posix_memalign(&block, RTEMATHBATCH_ALIGN, arrays * newCapacity * sizeof(RTEFLOAT)) != 0) {
+        RTeError("RTeMathBatch", QString("Failed to allocate %1 elements").arg(count));
+        return false;
+    }
+
+    for (int c = 0; c < arrays; c++) {
+        if (oldCount > 0)
+            memcpy((RTEFLOAT *)block + c * newCapacity, data[c], oldCount * sizeof(RTEFLOAT));
+    }
+    free(data[0]);
+    for (int c = 0; c < arrays; c++)
+        data[c] = (RTEFLOAT *)block + c * newCapacity;
+    capacity = newCapacity;
+    return true;
+}
+
+//----------------------------------------------------------
+//
+//  The RTeVector3SoA class
+
+RTeVector3SoA::RTeVector3SoA(int count)
+{
+    m_data[0] = m_data[1] = m_data[2] = NULL;
+    m_count = m_capacity = 0;
+    resize(count);
+}
+
+RTeVector3SoA::~RTeVector3SoA()
+{
+    free(m_data[0]);
+}
+
+void RTeVector3SoA::resize(int count)
+{
+    if (resizeArrays(m_data, 3, count, qMin(count, m_count), m_capacity))
+        m_count = count;
+}
+
+//----------------------------------------------------------
+//
+//  The RTeQuaternionSoA class
+
+RTeQuaternionSoA::RTeQuaternionSoA(int count)
+{
+    m_data[0] = m_data[1] = m_data[2] = m_data[3] = NULL;
+    m_count = m_capacity = 0;
+    resize(count);
+}
+
+RTeQuaternionSoA::~RTeQuaternionSoA()
+{
+    free(m_data[0]);
+}
+
+void RTeQuaternionSoA::resize(int count)
+{
+    if (resizeArrays(m_data, 4, count, qMin(count, m_count), m_capacity))
+        m_count = count;
+}
+
+//----------------------------------------------------------
+//
+//  SIMD kernels
+//
+//  RTeSIMD wraps the few operations the kernels need so the same kernel code
+//  is used for SSE2 and NEON. Each kernel processes whole vectors of elements
+//  and returns how many it did, the rest are done by the scalar code. The SoA
+//  arrays are aligned so the loads and stores can be too.
+
+#if defined(RTEMATHBATCH_SSE2)
+
+#define RTEMATHBATCH_SIMD_NAME          "SSE2"
+
+struct RTeSIMD
+{
+    typedef __m128 V;
+    enum { WIDTH = 4 };
+
+    static inline V load(const float *p) { return _mm_load_ps(p); }
+    static inline void store(float *p, V v) { _mm_store_ps(p, v); }
+    static inline V set1(float f) { return _mm_set1_ps(f); }
+    static inline V add(V a, V b) { return _mm_add_ps(a, b); }
+    static inline V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static inline V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static inline V div(V a, V b) { return _mm_div_ps(a, b); }
+    static inline V sqrt(V a) { return _mm_sqrt_ps(a); }
+
+    //  nonZero() replaces zeros with ones so they can be divided by
+
+    static inline V nonZero(V a)
+        { return _mm_add_ps(a, _mm_and_ps(_mm_cmpeq_ps(a, _mm_setzero_ps()), _mm_set1_ps(1.0f))); }
+};
+
+#elif defined(RTEMATHBATCH_NEON)
+
+#define RTEMATHBATCH_SIMD_NAME          "NEON"
+
+struct RTeSIMD
+{
+    typedef float32x4_t V;
+    enum { WIDTH = 4 };
+
+    static inline V load(const float *p) { return vld1q_f32(p); }
+    static inline void store(float *p, V v) { vst1q_f32(p, v); }
+    static inline V set1(float f) { return vdupq_n_f32(f); }
+    static inline V add(V a, V b) { return vaddq_f32(a, b); }
+    static inline V sub(V a, V b) { return vsubq_f32(a, b); }
+    static inline V mul(V a, V b) { return vmulq_f32(a, b); }
+
+#ifdef __aarch64__
+    static inline V div(V a, V b) { return vdivq_f32(a, b); }
+    static inline V sqrt(V a) { return vsqrtq_f32(a); }
+#else
+    //  32 bit NEON has no divide or square root, so use the estimates with
+    //  two Newton-Raphson steps
+
+    static inline V div(V a, V b)
+    {
+        V r = vrecpeq_f32(b);
+
+        r = vmulq_f32(vrecpsq_f32(b, r), r);
+        r = vmulq_f32(vrecpsq_f32(b, r), r);
+        return vmulq_f32(a, r);
+    }
+
+    static inline V sqrt(V a)
+    {
+        V m = vmaxq_f32(a, vdupq_n_f32(1e-30f));
+        V r = vrsqrteq_f32(m);
+
+        r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(m, r), r), r);
+        r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(m, r), r), r);
+        return vmulq_f32(a, r);
+    }
+#endif
+
+    static inline V nonZero(V a) { return vbslq_f32(vceqq_f32(a, vdupq_n_f32(0)), vdupq_n_f32(1.0f), a); }
+};
+
+#endif
+
+#ifdef RTEMATHBATCH_SIMD_NAME
+
+//  multiplyKernel() is the Hamilton product, in the same order as RTeQuaternion::operator *=.
+//  If broadcast is set a is a single quaternion.
+
+template <class S>
+static int multiplyKernel(const float *a[4], bool broadcast, const float *b[4], float *r[4], int count)
+{
+    typedef typename S::V V;
+    V as, ax, ay, az, bs, bx, by, bz, dot, cx, cy, cz;
+    int i;
+
+    if (count < S::WIDTH)
+        return 0;
+
+    as = S::set1(*a[0]);
+    ax = S::set1(*a[1]);
+    ay = S::set1(*a[2]);
+    az = S::set1(*a[3]);
+
+    for (i = 0; i + S::WIDTH <= count; i += S::WIDTH) {
+        if (!broadcast) {
+            as = S::load(a[0] + i);
+            ax = S::load(a[1] + i);
+            ay = S::load(a[2] + i);
+            az = S::load(a[3] + i);
+        }
+        bs = S::load(b[0] + i);
+        bx = S::load(b[1] + i);
+        by = S::load(b[2] + i);
+        bz = S::load(b[3] + i);
+
+        dot = S::add(S::add(S::mul(ax, bx), S::mul(ay, by)), S::mul(az, bz));
+        cx = S::sub(S::mul(ay, bz), S::mul(az, by));
+        cy = S::sub(S::mul(az, bx), S::mul(ax, bz));
+        cz = S::sub(S::mul(ax, by), S::mul(ay, bx));
+
+        S::store(r[0] + i, S::sub(S::mul(as, bs), dot));
+        S::store(r[1] + i, S::add(S::add(S::mul(as, bx), S::mul(bs, ax)), cx));
+        S::store(r[2] + i, S::add(S::add(S::mul(as, by), S::mul(bs, ay)), cy));
+        S::store(r[3] + i, S::add(S::add(S::mul(as, bz), S::mul(bs, az)), cz));
+    }
+    return i;
+}
+
+//  rotateKernel() uses v' = v + s * t + u x t where t = 2 * (u x v) and u is
+//  the vector part of q, which equals q * v * q.conjugate() for a unit q
+
+template <class S>
+static int rotateKernel(const float *q[4], bool broadcast, const float *v[3], float *r[3], int count)
+{
+    typedef typename S::V V;
+    const V two = S::set1(2.0f);
+    V qs, qx, qy, qz, vx, vy, vz, tx, ty, tz;
+    int i;
+
+    if (count < S::WIDTH)
+        return 0;
+
+    qs = S::set1(*q[0]);
+    qx = S::set1(*q[1]);
+    qy = S::set1(*q[2]);
+    qz = S::set1(*q[3]);
+
+    for (i = 0; i + S::WIDTH <= count; i += S::WIDTH) {
+        if (!broadcast) {
+            qs = S::load(q[0] + i);
+            qx = S::load(q[1] + i);
+            qy = S::load(q[2] + i);
+            qz = S::load(q[3] + i);
+        }
+        vx = S::load(v[0] + i);
+        vy = S::load(v[1] + i);
+        vz = S::load(v[2] + i);
+
+        tx = S::mul(two, S::sub(S::mul(qy, vz), S::mul(qz, vy)));
+        ty = S::mul(two, S::sub(S::mul(qz, vx), S::mul(qx, vz)));
+        tz = S::mul(two, S::sub(S::mul(qx, vy), S::mul(qy, vx)));
+
+        S::store(r[0] + i, S::add(S::add(vx, S::mul(qs, tx)), S::sub(S::mul(qy, tz), S::mul(qz, ty))));
+        S::store(r[1] + i, S::add(S::add(vy, S::mul(qs, ty)), S::sub(S::mul(qz, tx), S::mul(qx, tz))));
+        S::store(r[2] + i, S::add(S::add(vz, S::mul(qs, tz)), S::sub(S::mul(qx, ty), S::mul(qy, tx))));
+    }
+    return i;
+}
+
+//  normalizeKernel() leaves zero length elements alone, like the RTeQuaternion and RTeVector3 versions
+
+template <class S>
+static int normalizeKernel(float *data[], int components, int count)
+{
+    typedef typename S::V V;
+    V sum, length;
+    int i, c;
+
+    for (i = 0; i + S::WIDTH <= count; i += S::WIDTH) {
+        sum = S::set1(0);
+        for (c = 0; c < components; c++)
+            sum = S::add(sum, S::mul(S::load(data[c] + i), S::load(data[c] + i)));
+        length = S::nonZero(S::sqrt(sum));
+        for (c = 0; c < components; c++)
+            S::store(data[c] + i, S::div(S::load(data[c] + i), length));
+    }
+    return i;
+}
+
+#endif // RTEMATHBATCH_SIMD_NAME
+
+//----------------------------------------------------------
+//
+//  The RTeMathBatch class
+
+void RTeMathBatch::multiply(const RTeQuaternionSoA& a, const RTeQuaternionSoA& b, RTeQuaternionSoA& result)
+{
+    int count = qMin(a.count(), b.count());
+    int i = 0;
+
+    result.resize(count);
+    count = qMin(count, result.count());
+
+#ifdef RTEMATHBATCH_SIMD_NAME
+    if (g_useSIMD) {
+        const float *pa[4] = {a.scalar(), a.x(), a.y(), a.z()};
+        const float *pb[4] = {b.scalar(), b.x(), b.y(), b.z()};
+        float *pr[4] = {result.scalar(), result.x(), result.y(), result.z()};
+
+        i = multiplyKernel<RTeSIMD>(pa, false, pb, pr, count);
+    }
+#endif
+
+    for (; i < count; i++)
+        result.set(i, a.get(i) * b.get(i));
+}
+
+void RTeMathBatch::multiply(const RTeQuaternion& q, const RTeQuaternionSoA& b, RTeQuaternionSoA& result)
+{
+    int count = b.count();
+    int i = 0;
+
+    result.resize(count);
+    count = qMin(count, result.count());
+
+#ifdef RTEMATHBATCH_SIMD_NAME
+    if (g_useSIMD) {
+        const float qv[4] = {q.scalar(), q.x(), q.y(), q.z()};
+        const float *pa[4] = {qv, qv + 1, qv + 2, qv + 3};
+        const float *pb[4] = {b.scalar(), b.x(), b.y(), b.z()};
+        float *pr[4] = {result.scalar(), result.x(), result.y(), result.z()};
+
+        i = multiplyKernel<RTeSIMD>(pa, true, pb, pr, count);
+    }
+#endif
+
+    for (; i < count; i++)
+        result.set(i, q * b.get(i));
+}
+
+static inline RTeVector3 rotateVector(const RTeQuaternion& q, const RTeVector3& vec)
+{
+    RTeQuaternion p = q * RTeQuaternion(0, vec.x(), vec.y(), vec.z()) * q.conjugate();
+
+    return RTeVector3(p.x(), p.y(), p.z());
+}
+
+void RTeMathBatch::rotate(const RTeQuaternionSoA& q, const RTeVector3SoA& vec, RTeVector3SoA& result)
+{
+    int count = qMin(q.count(), vec.count());
+    int i = 0;
+
+    result.resize(count);
+    count = qMin(count, result.count());
+
+#ifdef RTEMATHBATCH_SIMD_NAME
+    if (g_useSIMD) {
+        const float *pq[4] = {q.scalar(), q.x(), q.y(), q.z()};
+        const float *pv[3] = {vec.x(), vec.y(), vec.z()};
+        float *pr[3] = {result.x(), result.y(), result.z()};
+
+        i = rotateKernel<RTeSIMD>(pq, false, pv, pr, count);
+    }
+#endif
+
+    for (; i < count; i++)
+        result.set(i, rotateVector(q.get(i), vec.get(i)));
+}
+
+void RTeMathBatch::rotate(const RTeQuaternion& q, const RTeVector3SoA& vec, RTeVector3SoA& result)
+{
+    int count = vec.count();
+    int i = 0;
+
+    result.resize(count);
+    count = qMin(count, result.count());
+
+#ifdef RTEMATHBATCH_SIMD_NAME
+    if (g_useSIMD) {
+        const float qv[4] = {q.scalar(), q.x(), q.y(), q.z()};
+        const float *pq[4] = {qv, qv + 1, qv + 2, qv + 3};
+        const float *pv[3] = {vec.x(), vec.y(), vec.z()};
+        float *pr[3] = {result.x(), result.y(), result.z()};
+
+        i = rotateKernel<RTeSIMD>(pq, true, pv, pr, count);
+    }
+#endif
+
+    for (; i < count; i++)
+        result.set(i, rotateVector(q, vec.get(i)));
+}
+
+void RTeMathBatch::normalize(RTeQuaternionSoA& quat)
+{
+    RTeQuaternion q;
+    int i = 0;
+
+#ifdef RTEMATHBATCH_SIMD_NAME
+    if (g_useSIMD) {
+        float *data[4] = {quat.scalar(), quat.x(), quat.y(), quat.z()};
+
+        i = normalizeKernel<RTeSIMD>(data, 4, quat.count());
+    }
+#endif
+
+    for (; i < quat.count(); i++) {
+        q = quat.get(i);
+        q.normalize();
+        quat.set(i, q);
+    }
+}
+
+void RTeMathBatch::normalize(RTeVector3SoA& vec)
+{
+    RTeVector3 v;
+    int i = 0;
+
+#ifdef RTEMATHBATCH_SIMD_NAME
+    if (g_useSIMD) {
+        float *data[3] = {vec.x(), vec.y(), vec.z()};
+
+        i = normalizeKernel<RTeSIMD>(data, 3, vec.count());
+    }
+#endif
+
+    for (; i < vec.count(); i++) {
+        v = vec.get(i);
+        v.normalize();
+        vec.set(i, v);
+    }
+}
+
+void RTeMathBatch::toEuler(const RTeQuaternionSoA& quat, RTeVector3SoA& vec)
+{
+    RTeVector3 v;
+
+    vec.resize(quat.count());
+    for (int i = 0; i < qMin(quat.count(), vec.count()); i++) {
+        quat.get(i).toEuler(v);
+        vec.set(i, v);
+    }
+}
+
+void RTeMathBatch::fromEuler(const RTeVector3SoA& vec, RTeQuaternionSoA& quat)
+{
+    RTeQuaternion q;
+
+    quat.resize(vec.count());
+    for (int i = 0; i < qMin(vec.count(), quat.count()); i++) {
+        q.fromEuler(vec.get(i));
+        quat.set(i, q);
+    }
+}
+
+void RTeMathBatch::slerp(const RTeQuaternionSoA& a, const RTeQuaternionSoA& b, const RTEFLOAT *t,
+                         RTeQuaternionSoA& result)
+{
+    int count = qMin(a.count(), b.count());
+
+    result.resize(count);
+    for (int i = 0; i < qMin(count, result.count()); i++)
+        result.set(i, slerp(a.get(i), b.get(i), t[i]));
+}
+
+RTeQuaternion RTeMathBatch::slerp(const RTeQuaternion& a, const RTeQuaternion& b, RTEFLOAT t)
+{
+    RTeQuaternion end = b;
+    RTeQuaternion result;
+    RTEFLOAT dot = a.scalar() * b.scalar() + a.x() * b.x() + a.y() * b.y() + a.z() * b.z();
+    RTEFLOAT theta;
+    RTEFLOAT sinTheta;
+
+    //  q and -q are the same rotation, pick the one that's closer
+
+    if (dot < 0) {
+        end *= -1;
+        dot = -dot;
+    }
+
+    if (dot > RTEMATHBATCH_SLERP_LINEAR) {
+        result = a;
+        result += (end - a) * t;
+        result.normalize();
+        return result;
+    }
+
+    theta = acos(dot);
+    sinTheta = sin(theta);
+    result = a * (RTEFLOAT)(sin((1 - t) * theta) / sinTheta);
+    result += end * (RTEFLOAT)(sin(t * theta) / sinTheta);
+    return result;
+}
+
+void RTeMathBatch::setUseSIMD(bool enable)
+{
+    g_useSIMD = enable;
+}
+
+bool RTeMathBatch::useSIMD()
+{
+#ifdef RTEMATHBATCH_SIMD_NAME
+    return g_useSIMD;
+#else
+    return false;
+#endif
+}
+
+const char *RTeMathBatch::simdName()
+{
+#ifdef RTEMATHBATCH_SIMD_NAME
+    return RTEMATHBATCH_SIMD_NAME;
+#else
+    return "none";
+#endif
+}
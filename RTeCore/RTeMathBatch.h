@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTEMATHBATCH_H_
+#define _RTEMATHBATCH_H_
+
+#include "RTeMath.h"
+
+#define RTEMATHBATCH_ALIGN              64                  // byte alignment of each SoA array
+
+//  RTeVector3SoA and RTeQuaternionSoA hold blocks of vectors and quaternions
+//  as one array per component so the batch routines can process several
+//  elements per instruction. Each array is aligned to RTEMATHBATCH_ALIGN.
+
+class RTeVector3SoA
+{
+public:
+    RTeVector3SoA(int count = 0);
+    ~RTeVector3SoA();
+
+    //  resize() keeps the existing values that still fit
+
+    void resize(int count);
+    int count() const { return m_count; }
+
+    inline RTEFLOAT *x() { return m_data[0]; }
+    inline RTEFLOAT *y() { return m_data[1]; }
+    inline RTEFLOAT *z() { return m_data[2]; }
+    inline const RTEFLOAT *x() const { return m_data[0]; }
+    inline const RTEFLOAT *y() const { return m_data[1]; }
+    inline const RTEFLOAT *z() const { return m_data[2]; }
+
+    inline RTeVector3 get(int i) const { return RTeVector3(m_data[0][i], m_data[1][i], m_data[2][i]); }
+    inline void set(int i, const RTeVector3& vec)
+        { m_data[0][i] = vec.x(); m_data[1][i] = vec.y(); m_data[2][i] = vec.z(); }
+
+private:
+    RTeVector3SoA(const RTeVector3SoA&);
+    RTeVector3SoA& operator=(const RTeVector3SoA&);
+
+    RTEFLOAT *m_data[3];                                    // x, y and z arrays (one allocation)
+    int m_count;
+    int m_capacity;
+};
+
+class RTeQuaternionSoA
+{
+public:
+    RTeQuaternionSoA(int count = 0);
+    ~RTeQuaternionSoA();
+
+    void resize(int count);
+    int count() const { return m_count; }
+
+    inline RTEFLOAT *scalar() { return m_data[0]; }
+    inline RTEFLOAT *x() { return m_data[1]; }
+    inline RTEFLOAT *y() { return m_data[2]; }
+    inline RTEFLOAT *z() { return m_data[3]; }
+    inline const RTEFLOAT *scalar() const { return m_data[0]; }
+    inline const RTEFLOAT *x() const { return m_data[1]; }
+    inline const RTEFLOAT *y() const { return m_data[2]; }
+    inline const RTEFLOAT *z() const { return m_data[3]; }
+
+    inline RTeQuaternion get(int i) const
+        { return RTeQuaternion(m_data[0][i], m_data[1][i], m_data[2][i], m_data[3][i]); }
+    inline void set(int i, const RTeQuaternion& quat)
+        { for (int c = 0; c < 4; c++) m_data[c][i] = quat.data(c); }
+
+private:
+    RTeQuaternionSoA(const RTeQuaternionSoA&);
+    RTeQuaternionSoA& operator=(const RTeQuaternionSoA&);
+
+    RTEFLOAT *m_data[4];                                    // scalar, x, y and z arrays (one allocation)
+    int m_count;
+    int m_capacity;
+};
+
+//  RTeMathBatch applies the RTeQuaternion and RTeVector3 operations to whole
+//  blocks. Results are resized to match the inputs and may be the same
+//  object as an input. Multiply, rotate and normalize use SSE2 or NEON when
+//  available. The Euler conversions and slerp are limited by the trig
+//  functions and are plain loops.
+//
+//  setUseSIMD(false) makes everything use the scalar reference code, which
+//  calls the RTeQuaternion and RTeVector3 functions for each element.
+
+class RTeMathBatch
+{
+public:
+    //  multiply() sets result[i] = a[i] * b[i], or q * b[i]
+
+    static void multiply(const RTeQuaternionSoA& a, const RTeQuaternionSoA& b, RTeQuaternionSoA& result);
+    static void multiply(const RTeQuaternion& q, const RTeQuaternionSoA& b, RTeQuaternionSoA& result);
+
+    //  rotate() rotates each vector by q[i] or q (q * v * q.conjugate()). The quaternions must be normalized.
+
+    static void rotate(const RTeQuaternionSoA& q, const RTeVector3SoA& vec, RTeVector3SoA& result);
+    static void rotate(const RTeQuaternion& q, const RTeVector3SoA& vec, RTeVector3SoA& result);
+
+    static void normalize(RTeQuaternionSoA& quat);
+    static void normalize(RTeVector3SoA& vec);
+
+    static void toEuler(const RTeQuaternionSoA& quat, RTeVector3SoA& vec);
+    static void fromEuler(const RTeVector3SoA& vec, RTeQuaternionSoA& quat);
+
+    //  slerp() interpolates from a[i] (t[i] = 0) to b[i] (t[i] = 1) along the shorter arc
+
+    static void slerp(const RTeQuaternionSoA& a, const RTeQuaternionSoA& b, const RTEFLOAT *t,
+                      RTeQuaternionSoA& result);
+    static RTeQuaternion slerp(const RTeQuaternion& a, const RTeQuaternion& b, RTEFLOAT t);
+
+    static void setUseSIMD(bool enable);
+    static bool useSIMD();
+    static const char *simdName();                          // "SSE2", "NEON" or "none"
+};
+
+#endif // _RTEMATHBATCH_H_
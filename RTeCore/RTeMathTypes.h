@@ -0,0 +1,508 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTEMATHTYPES_H_
+#define _RTEMATHTYPES_H_
+
+#include <math.h>
+#include <qstring.h>
+
+//  RTeVector3T, RTeQuaternionT and RTeMatrix4x4T are templates on the element
+//  type so that, for example, float samples can be accumulated in double.
+//  Everything is defined here so that it can be inlined, and they have no
+//  user defined copy operations so they are trivially copyable and can be
+//  memcpy'd or held in lock free queues. RTeMath.h defines RTeVector3,
+//  RTeQuaternion and RTeMatrix4x4 as the RTEFLOAT versions.
+//
+//  The constructors and accessors are constexpr when compiled as C++11.
+
+#if __cplusplus >= 201103L
+#define RTEMATH_CONSTEXPR               constexpr
+#else
+#define RTEMATH_CONSTEXPR
+#endif
+
+template <typename T> class RTeQuaternionT;
+
+template <typename T>
+class RTeVector3T
+{
+public:
+    RTEMATH_CONSTEXPR RTeVector3T() : m_data() {}
+#if __cplusplus >= 201103L
+    constexpr RTeVector3T(T x, T y, T z) : m_data{x, y, z} {}
+#else
+    RTeVector3T(T x, T y, T z) { m_data[0] = x; m_data[1] = y; m_data[2] = z; }
+#endif
+
+    template <typename U>
+    explicit RTeVector3T(const RTeVector3T<U>& vec)
+        { m_data[0] = (T)vec.x(); m_data[1] = (T)vec.y(); m_data[2] = (T)vec.z(); }
+
+    inline const RTeVector3T& operator +=(const RTeVector3T& vec)
+        { m_data[0] += vec.m_data[0]; m_data[1] += vec.m_data[1]; m_data[2] += vec.m_data[2]; return *this; }
+    inline const RTeVector3T& operator -=(const RTeVector3T& vec)
+        { m_data[0] -= vec.m_data[0]; m_data[1] -= vec.m_data[1]; m_data[2] -= vec.m_data[2]; return *this; }
+
+    inline T length() const { return sqrt(dotProduct(*this, *this)); }
+    void normalize();
+    inline void zero() { m_data[0] = m_data[1] = m_data[2] = 0; }
+    inline bool isZero() const { return (m_data[0] == 0) && (m_data[1] == 0) && (m_data[2] == 0); }
+    QString display(const QString &label) const;
+
+    static RTEMATH_CONSTEXPR T dotProduct(const RTeVector3T& a, const RTeVector3T& b)
+        { return a.m_data[0] * b.m_data[0] + a.m_data[1] * b.m_data[1] + a.m_data[2] * b.m_data[2]; }
+    static void crossProduct(const RTeVector3T& a, const RTeVector3T& b, RTeVector3T& d);
+
+    void accelToEuler(RTeVector3T& rollPitchYaw) const;
+    void accelToQuaternion(RTeQuaternionT<T>& qPose) const;
+
+    inline RTEMATH_CONSTEXPR T x() const { return m_data[0]; }
+    inline RTEMATH_CONSTEXPR T y() const { return m_data[1]; }
+    inline RTEMATH_CONSTEXPR T z() const { return m_data[2]; }
+    inline RTEMATH_CONSTEXPR T data(const int i) const { return m_data[i]; }
+
+    inline void setX(const T val) { m_data[0] = val; }
+    inline void setY(const T val) { m_data[1] = val; }
+    inline void setZ(const T val) { m_data[2] = val; }
+    inline void setData(const int i, T val) { m_data[i] = val; }
+
+private:
+    T m_data[3];
+};
+
+
+template <typename T>
+class RTeQuaternionT
+{
+public:
+    RTEMATH_CONSTEXPR RTeQuaternionT() : m_data() {}
+#if __cplusplus >= 201103L
+    constexpr RTeQuaternionT(T scalar, T x, T y, T z) : m_data{scalar, x, y, z} {}
+#else
+    RTeQuaternionT(T scalar, T x, T y, T z) { m_data[0] = scalar; m_data[1] = x; m_data[2] = y; m_data[3] = z; }
+#endif
+
+    template <typename U>
+    explicit RTeQuaternionT(const RTeQuaternionT<U>& quat)
+        { for (int i = 0; i < 4; i++) m_data[i] = (T)quat.data(i); }
+
+    inline RTeQuaternionT& operator +=(const RTeQuaternionT& quat)
+        { for (int i = 0; i < 4; i++) m_data[i] += quat.m_data[i]; return *this; }
+    inline RTeQuaternionT& operator -=(const RTeQuaternionT& quat)
+        { for (int i = 0; i < 4; i++) m_data[i] -= quat.m_data[i]; return *this; }
+    RTeQuaternionT& operator *=(const RTeQuaternionT& qb);
+    inline RTeQuaternionT& operator *=(const T val)
+        { for (int i = 0; i < 4; i++) m_data[i] *= val; return *this; }
+    inline RTeQuaternionT& operator -=(const T val)
+        { for (int i = 0; i < 4; i++) m_data[i] -= val; return *this; }
+
+    inline const RTeQuaternionT operator *(const RTeQuaternionT& qb) const { RTeQuaternionT result = *this; return result *= qb; }
+    inline const RTeQuaternionT operator *(const T val) const { RTeQuaternionT result = *this; return result *= val; }
+    inline const RTeQuaternionT operator -(const RTeQuaternionT& qb) const { RTeQuaternionT result = *this; return result -= qb; }
+    inline const RTeQuaternionT operator -(const T val) const { RTeQuaternionT result = *this; return result -= val; }
+
+    void normalize();
+    void toEuler(RTeVector3T<T>& vec) const;
+    void fromEuler(const RTeVector3T<T>& vec);
+    inline RTEMATH_CONSTEXPR RTeQuaternionT conjugate() const
+        { return RTeQuaternionT(m_data[0], -m_data[1], -m_data[2], -m_data[3]); }
+    void toAngleVector(T& angle, RTeVector3T<T>& vec) const;
+    void fromAngleVector(const T& angle, const RTeVector3T<T>& vec);
+
+    inline void zero() { m_data[0] = m_data[1] = m_data[2] = m_data[3] = 0; }
+
+    inline RTEMATH_CONSTEXPR T scalar() const { return m_data[0]; }
+    inline RTEMATH_CONSTEXPR T x() const { return m_data[1]; }
+    inline RTEMATH_CONSTEXPR T y() const { return m_data[2]; }
+    inline RTEMATH_CONSTEXPR T z() const { return m_data[3]; }
+    inline RTEMATH_CONSTEXPR T data(const int i) const { return m_data[i]; }
+
+    inline void setScalar(const T val) { m_data[0] = val; }
+    inline void setX(const T val) { m_data[1] = val; }
+    inline void setY(const T val) { m_data[2] = val; }
+    inline void setZ(const T val) { m_data[3] = val; }
+    inline void setData(const int i, T val) { m_data[i] = val; }
+
+private:
+    T m_data[4];
+};
+
+
+template <typename T>
+class RTeMatrix4x4T
+{
+public:
+    RTEMATH_CONSTEXPR RTeMatrix4x4T() : m_data() {}
+
+    template <typename U>
+    explicit RTeMatrix4x4T(const RTeMatrix4x4T<U>& mat)
+    {
+        for (int row = 0; row < 4; row++)
+            for (int col = 0; col < 4; col++)
+                m_data[row][col] = (T)mat.val(row, col);
+    }
+
+    RTeMatrix4x4T& operator +=(const RTeMatrix4x4T& mat);
+    RTeMatrix4x4T& operator -=(const RTeMatrix4x4T& mat);
+    RTeMatrix4x4T& operator *=(const T val);
+
+    const RTeQuaternionT<T> operator *(const RTeQuaternionT<T>& q) const;
+    inline const RTeMatrix4x4T operator *(const T val) const { RTeMatrix4x4T result = *this; return result *= val; }
+    const RTeMatrix4x4T operator *(const RTeMatrix4x4T& mat) const;
+    inline const RTeMatrix4x4T operator +(const RTeMatrix4x4T& mat) const { RTeMatrix4x4T result = *this; return result += mat; }
+
+    inline RTEMATH_CONSTEXPR T val(int row, int col) const { return m_data[row][col]; }
+    inline void setVal(int row, int col, T val) { m_data[row][col] = val; }
+    void fill(T val);
+    void setToIdentity();
+
+    RTeMatrix4x4T inverted() const;
+    RTeMatrix4x4T transposed() const;
+
+private:
+    T m_data[4][4];                                         // row, column
+
+    T matDet() const;
+    T matMinor(const int row, const int col) const;
+};
+
+
+//----------------------------------------------------------
+//
+//  The RTeVector3T class
+
+template <typename T>
+void RTeVector3T<T>::normalize()
+{
+    T length = this->length();
+
+    if (length == 0)
+        return;
+
+    m_data[0] /= length;
+    m_data[1] /= length;
+    m_data[2] /= length;
+}
+
+template <typename T>
+QString RTeVector3T<T>::display(const QString& label) const
+{
+    QString result;
+
+    result.sprintf("%s: x:%f, y:%f, z:%f", qPrintable(label), (double)m_data[0], (double)m_data[1], (double)m_data[2]);
+    return result;
+}
+
+template <typename T>
+void RTeVector3T<T>::crossProduct(const RTeVector3T& a, const RTeVector3T& b, RTeVector3T& d)
+{
+    d.setX(a.y() * b.z() - a.z() * b.y());
+    d.setY(a.z() * b.x() - a.x() * b.z());
+    d.setZ(a.x() * b.y() - a.y() * b.x());
+}
+
+template <typename T>
+void RTeVector3T<T>::accelToEuler(RTeVector3T& rollPitchYaw) const
+{
+    RTeVector3T normAccel = *this;
+
+    normAccel.normalize();
+
+    rollPitchYaw.setX(atan2(normAccel.y(), normAccel.z()));
+    rollPitchYaw.setY(-atan2(normAccel.x(), sqrt(normAccel.y() * normAccel.y() + normAccel.z() * normAccel.z())));
+    rollPitchYaw.setZ(0);
+}
+
+template <typename T>
+void RTeVector3T<T>::accelToQuaternion(RTeQuaternionT<T>& qPose) const
+{
+    RTeVector3T normAccel = *this;
+    RTeVector3T vec;
+    RTeVector3T z(0, 0, 1.0);
+
+    normAccel.normalize();
+
+    T angle = acos(dotProduct(z, normAccel));
+    crossProduct(normAccel, z, vec);
+    vec.normalize();
+
+    qPose.fromAngleVector(angle, vec);
+}
+
+
+//----------------------------------------------------------
+//
+//  The RTeQuaternionT class
+
+template <typename T>
+RTeQuaternionT<T>& RTeQuaternionT<T>::operator *=(const RTeQuaternionT& qb)
+{
+    RTeVector3T<T> va(m_data[1], m_data[2], m_data[3]);
+    RTeVector3T<T> vb(qb.x(), qb.y(), qb.z());
+    RTeVector3T<T> crossAB;
+    T dotAB;
+
+    dotAB = RTeVector3T<T>::dotProduct(va, vb);
+    RTeVector3T<T>::crossProduct(va, vb, crossAB);
+    T myScalar = m_data[0];
+
+    m_data[0] = myScalar * qb.scalar() - dotAB;
+    m_data[1] = myScalar * vb.x() + qb.scalar() * va.x() + crossAB.x();
+    m_data[2] = myScalar * vb.y() + qb.scalar() * va.y() + crossAB.y();
+    m_data[3] = myScalar * vb.z() + qb.scalar() * va.z() + crossAB.z();
+
+    return *this;
+}
+
+template <typename T>
+void RTeQuaternionT<T>::normalize()
+{
+    T length = sqrt(m_data[0] * m_data[0] + m_data[1] * m_data[1] +
+            m_data[2] * m_data[2] + m_data[3] * m_data[3]);
+
+    if ((length == 0) || (length == 1))
+        return;
+
+    m_data[0] /= length;
+    m_data[1] /= length;
+    m_data[2] /= length;
+    m_data[3] /= length;
+}
+
+template <typename T>
+void RTeQuaternionT<T>::toEuler(RTeVector3T<T>& vec) const
+{
+    vec.setX(atan2(2.0 * (m_data[2] * m_data[3] + m_data[0] * m_data[1]),
+            1 - 2.0 * (m_data[1] * m_data[1] + m_data[2] * m_data[2])));
+
+    vec.setY(asin(2.0 * (m_data[0] * m_data[2] - m_data[1] * m_data[3])));
+
+    vec.setZ(atan2(2.0 * (m_data[1] * m_data[2] + m_data[0] * m_data[3]),
+            1 - 2.0 * (m_data[2] * m_data[2] + m_data[3] * m_data[3])));
+}
+
+template <typename T>
+void RTeQuaternionT<T>::fromEuler(const RTeVector3T<T>& vec)
+{
+    T cosX2 = cos(vec.x() / 2.0f);
+    T sinX2 = sin(vec.x() / 2.0f);
+    T cosY2 = cos(vec.y() / 2.0f);
+    T sinY2 = sin(vec.y() / 2.0f);
+    T cosZ2 = cos(vec.z() / 2.0f);
+    T sinZ2 = sin(vec.z() / 2.0f);
+
+    m_data[0] = cosX2 * cosY2 * cosZ2 + sinX2 * sinY2 * sinZ2;
+    m_data[1] = sinX2 * cosY2 * cosZ2 - cosX2 * sinY2 * sinZ2;
+    m_data[2] = cosX2 * sinY2 * cosZ2 + sinX2 * cosY2 * sinZ2;
+    m_data[3] = cosX2 * cosY2 * sinZ2 - sinX2 * sinY2 * cosZ2;
+    normalize();
+}
+
+template <typename T>
+void RTeQuaternionT<T>::toAngleVector(T& angle, RTeVector3T<T>& vec) const
+{
+    T halfTheta;
+    T sinHalfTheta;
+
+    halfTheta = acos(m_data[0]);
+    sinHalfTheta = sin(halfTheta);
+
+    if (sinHalfTheta == 0) {
+        vec.setX(1.0);
+        vec.setY(0);
+        vec.setZ(0);
+    } else {
+        vec.setX(m_data[1] / sinHalfTheta);
+        vec.setY(m_data[2] / sinHalfTheta);
+        vec.setZ(m_data[3] / sinHalfTheta);
+    }
+    angle = 2.0 * halfTheta;
+}
+
+template <typename T>
+void RTeQuaternionT<T>::fromAngleVector(const T& angle, const RTeVector3T<T>& vec)
+{
+    T sinHalfTheta = sin(angle / 2.0);
+    m_data[0] = cos(angle / 2.0);
+    m_data[1] = vec.x() * sinHalfTheta;
+    m_data[2] = vec.y() * sinHalfTheta;
+    m_data[3] = vec.z() * sinHalfTheta;
+}
+
+
+//----------------------------------------------------------
+//
+//  The RTeMatrix4x4T class
+
+template <typename T>
+void RTeMatrix4x4T<T>::fill(T val)
+{
+    for (int row = 0; row < 4; row++)
+        for (int col = 0; col < 4; col++)
+            m_data[row][col] = val;
+}
+
+template <typename T>
+RTeMatrix4x4T<T>& RTeMatrix4x4T<T>::operator +=(const RTeMatrix4x4T& mat)
+{
+    for (int row = 0; row < 4; row++)
+        for (int col = 0; col < 4; col++)
+            m_data[row][col] += mat.m_data[row][col];
+
+    return *this;
+}
+
+template <typename T>
+RTeMatrix4x4T<T>& RTeMatrix4x4T<T>::operator -=(const RTeMatrix4x4T& mat)
+{
+    for (int row = 0; row < 4; row++)
+        for (int col = 0; col < 4; col++)
+            m_data[row][col] -= mat.m_data[row][col];
+
+    return *this;
+}
+
+template <typename T>
+RTeMatrix4x4T<T>& RTeMatrix4x4T<T>::operator *=(const T val)
+{
+    for (int row = 0; row < 4; row++)
+        for (int col = 0; col < 4; col++)
+            m_data[row][col] *= val;
+
+    return *this;
+}
+
+template <typename T>
+const RTeMatrix4x4T<T> RTeMatrix4x4T<T>::operator *(const RTeMatrix4x4T& mat) const
+{
+    RTeMatrix4x4T res;
+
+    for (int row = 0; row < 4; row++)
+        for (int col = 0; col < 4; col++)
+            res.m_data[row][col] =
+                    m_data[row][0] * mat.m_data[0][col] +
+                    m_data[row][1] * mat.m_data[1][col] +
+                    m_data[row][2] * mat.m_data[2][col] +
+                    m_data[row][3] * mat.m_data[3][col];
+
+    return res;
+}
+
+template <typename T>
+const RTeQuaternionT<T> RTeMatrix4x4T<T>::operator *(const RTeQuaternionT<T>& q) const
+{
+    RTeQuaternionT<T> res;
+
+    res.setScalar(m_data[0][0] * q.scalar() + m_data[0][1] * q.x() + m_data[0][2] * q.y() + m_data[0][3] * q.z());
+    res.setX(m_data[1][0] * q.scalar() + m_data[1][1] * q.x() + m_data[1][2] * q.y() + m_data[1][3] * q.z());
+    res.setY(m_data[2][0] * q.scalar() + m_data[2][1] * q.x() + m_data[2][2] * q.y() + m_data[2][3] * q.z());
+    res.setZ(m_data[3][0] * q.scalar() + m_data[3][1] * q.x() + m_data[3][2] * q.y() + m_data[3][3] * q.z());
+
+    return res;
+}
+
+template <typename T>
+void RTeMatrix4x4T<T>::setToIdentity()
+{
+    fill(0);
+    m_data[0][0] = 1;
+    m_data[1][1] = 1;
+    m_data[2][2] = 1;
+    m_data[3][3] = 1;
+}
+
+template <typename T>
+RTeMatrix4x4T<T> RTeMatrix4x4T<T>::transposed() const
+{
+    RTeMatrix4x4T res;
+
+    for (int row = 0; row < 4; row++)
+        for (int col = 0; col < 4; col++)
+            res.m_data[col][row] = m_data[row][col];
+    return res;
+}
+
+//  Note:
+//  The matrix inversion code here was strongly influenced by some old code I found
+//  but I have no idea where it came from. Apologies to whoever wrote it originally!
+//  If it's you, please let me know at info@richards-tech.com so I can credit it correctly.
+
+template <typename T>
+RTeMatrix4x4T<T> RTeMatrix4x4T<T>::inverted() const
+{
+    RTeMatrix4x4T res;
+
+    T det = matDet();
+
+    if (det == 0) {
+        res.setToIdentity();
+        return res;
+    }
+
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            if ((row + col) & 1)
+                res.m_data[col][row] = -matMinor(row, col) / det;
+            else
+                res.m_data[col][row] = matMinor(row, col) / det;
+        }
+    }
+
+    return res;
+}
+
+template <typename T>
+T RTeMatrix4x4T<T>::matDet() const
+{
+    T det = 0;
+
+    det += m_data[0][0] * matMinor(0, 0);
+    det -= m_data[0][1] * matMinor(0, 1);
+    det += m_data[0][2] * matMinor(0, 2);
+    det -= m_data[0][3] * matMinor(0, 3);
+    return det;
+}
+
+template <typename T>
+T RTeMatrix4x4T<T>::matMinor(const int row, const int col) const
+{
+    static const int map[] = {1, 2, 3, 0, 2, 3, 0, 1, 3, 0, 1, 2};
+
+    const int *rc;
+    const int *cc;
+    T res = 0;
+
+    rc = map + row * 3;
+    cc = map + col * 3;
+
+    res += m_data[rc[0]][cc[0]] * m_data[rc[1]][cc[1]] * m_data[rc[2]][cc[2]];
+    res -= m_data[rc[0]][cc[0]] * m_data[rc[1]][cc[2]] * m_data[rc[2]][cc[1]];
+    res -= m_data[rc[0]][cc[1]] * m_data[rc[1]][cc[0]] * m_data[rc[2]][cc[2]];
+    res += m_data[rc[0]][cc[1]] * m_data[rc[1]][cc[2]] * m_data[rc[2]][cc[0]];
+    res += m_data[rc[0]][cc[2]] * m_data[rc[1]][cc[0]] * m_data[rc[2]][cc[1]];
+    res -= m_data[rc[0]][cc[2]] * m_data[rc[1]][cc[1]] * m_data[rc[2]][cc[0]];
+    return res;
+}
+
+#endif // _RTEMATHTYPES_H_
@@ -25,4 +25,5 @@
 
 RTeModule::RTeModule(QObject *parent) : QObject(parent)
 {
+    m_useExecutor = false;
 }
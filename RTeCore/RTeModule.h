@@ -43,6 +43,13 @@ public:
     const QString& getModuleName() { return m_moduleName; }
     void setModuleName(const QString& name) { m_moduleName = name; }
 
+    //  setUseExecutor("true") runs the module on a shared RTeExecutor thread
+    //  instead of its own (threaded modules) or the caller's (object modules).
+    //  A module on the executor must never block in a slot or timer - it would
+    //  hold up every other module on the pool thread. Use timers instead.
+
+    void setUseExecutor(const QString& use) { m_useExecutor = use == "true"; }
+
     //  resumeThread() is called when init is complete
 
     virtual void resumeThread() = 0;
@@ -58,6 +65,7 @@ protected:
     virtual void stopModule() = 0;                          // closes down module
 
     QString m_moduleName;
+    bool m_useExecutor;                                     // true to run on a pool thread
 
 };
 
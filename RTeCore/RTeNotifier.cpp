@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RTeNotifier.h"
+#include "RTeClock.h"
+
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+
+RTeNotifier::RTeNotifier()
+{
+    m_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_pending = 0;
+    m_batchItems = 1;
+    m_batchDelay = 0;
+    m_woken = false;
+}
+
+RTeNotifier::~RTeNotifier()
+{
+    if (m_fd != -1)
+        close(m_fd);
+}
+
+void RTeNotifier::setBatching(int items, int delay)
+{
+    m_batchItems = items > 1 ? items : 1;
+    m_batchDelay = delay > 0 ? (qint64)delay * 1000 : 0;
+}
+
+void RTeNotifier::signal()
+{
+    uint64_t one = 1;
+
+    if (write(m_fd, &one, sizeof(one)) < 0) {
+        //  EAGAIN means the counter is saturated, which still wakes the reader
+    }
+}
+
+void RTeNotifier::wake()
+{
+    __atomic_store_n(&m_woken, true, __ATOMIC_RELEASE);
+    signal();
+}
+
+int RTeNotifier::wait(int msecs)
+{
+    struct pollfd fds;
+    struct timespec timeout;
+    uint64_t count;
+    qint64 now = RTeClock::currentNSecs(CLOCK_MONOTONIC);
+    qint64 deadline = msecs >= 0 ? now + (qint64)msecs * 1000000 : -1;
+    qint64 batchDeadline = -1;
+    qint64 wakeAt;
+    quint32 pending;
+
+    fds.fd = m_fd;
+    fds.events = POLLIN;
+
+    while (1) {
+        pending = __atomic_load_n(&m_pending, __ATOMIC_ACQUIRE);
+
+        //  a wake() is consumed where it is seen so one that arrives later isn't lost
+
+        if ((pending >= m_batchItems) || __atomic_exchange_n(&m_woken, false, __ATOMIC_ACQUIRE))
+            break;
+
+        //  the batch delay starts when the consumer first sees an item
+
+        if ((pending > 0) && (batchDeadline < 0))
+            batchDeadline = now + m_batchDelay;
+
+        wakeAt = deadline;
+        if ((batchDeadline >= 0) && ((wakeAt < 0) || (batchDeadline < wakeAt)))
+            wakeAt = batchDeadline;
+
+        if ((wakeAt >= 0) && (now >= wakeAt))
+            break;
+
+        if (wakeAt >= 0) {
+            timeout.tv_sec = (wakeAt - now) / 1000000000;
+            timeout.tv_nsec = (wakeAt - now) % 1000000000;
+        }
+
+        if ((ppoll(&fds, 1, wakeAt >= 0 ? &timeout : NULL, NULL) < 0) && (errno == EINTR))
+            break;                                          // let the caller see the signal
+
+        if (fds.revents & POLLIN) {
+            if (read(m_fd, &count, sizeof(count)) < 0) {
+                //  another wait() got there first
+            }
+        }
+        now = RTeClock::currentNSecs(CLOCK_MONOTONIC);
+    }
+
+    return (int)__atomic_exchange_n(&m_pending, 0, __ATOMIC_ACQ_REL);
+}
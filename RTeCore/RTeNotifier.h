@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTENOTIFIER_H_
+#define _RTENOTIFIER_H_
+
+#include <qglobal.h>
+
+#define RTENOTIFIER_IDLE_WAIT           100                 // mS the main loop waits with nothing notified
+
+//  RTeNotifier lets a consumer thread sleep until producers have queued
+//  something for it. Producers call notify() after queueing, the consumer
+//  calls wait() and then empties its queues.
+//
+//  The eventfd is only written when the count of queued items goes from zero
+//  to non-zero or reaches the batch size, so a busy producer doesn't make a
+//  system call per item. With batching the consumer wakes once the batch
+//  size is reached or the delay has passed since the first item arrived.
+
+class RTeNotifier
+{
+public:
+    RTeNotifier();
+    ~RTeNotifier();
+
+    //  setBatching() sets the number of items or the delay in uS after the
+    //  first item that wake the consumer. The default is 1 item (no batching).
+
+    void setBatching(int items, int delay);
+
+    //  notify() is called by producers when count items have been queued
+
+    inline void notify(int count = 1)
+    {
+        quint32 previous = __atomic_fetch_add(&m_pending, count, __ATOMIC_RELEASE);
+
+        if ((previous == 0) || ((previous < m_batchItems) && (previous + count >= m_batchItems)))
+            signal();
+    }
+
+    //  wake() makes wait() return whether or not anything is pending
+
+    void wake();
+
+    //  wait() blocks for up to msecs (-1 for ever) until a batch is ready or
+    //  wake() is called. It returns the number of items notified since the last wait().
+
+    int wait(int msecs);
+
+private:
+    void signal();
+
+    int m_fd;                                               // eventfd written to wake the consumer
+    quint32 m_pending;                                      // items notified since the last wait()
+    quint32 m_batchItems;                                   // items that wake the consumer
+    qint64 m_batchDelay;                                    // nS after the first item that wake the consumer
+    bool m_woken;                                           // wake() was called
+};
+
+#endif // _RTENOTIFIER_H_
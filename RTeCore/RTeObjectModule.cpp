@@ -22,7 +22,58 @@
 //  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "RTeObjectModule.h"
+#include "RTeExecutor.h"
 
 RTeObjectModule::RTeObjectModule(QObject *parent) : RTeModule(parent)
 {
+    m_executorThread = NULL;
+    m_ownerThread = NULL;
+}
+
+void RTeObjectModule::resumeThread()
+{
+    if (!m_useExecutor) {
+        initModule();
+        return;
+    }
+
+    //  a module with a parent can't change thread
+
+    if (parent() != NULL) {
+        RTeWarning(getModuleName(), "Module with a parent can't use the executor");
+        initModule();
+        return;
+    }
+
+    m_ownerThread = thread();
+    m_executorThread = RTeExecutor::instance()->acquire();
+    moveToThread(m_executorThread);
+    QMetaObject::invokeMethod(this, "internalInit", Qt::QueuedConnection);
+}
+
+void RTeObjectModule::exitThread()
+{
+    if (m_executorThread == NULL) {
+        stopModule();
+        return;
+    }
+
+    //  wait for the module to stop so that the caller can delete it afterwards
+
+    if (QThread::currentThread() == m_executorThread)
+        internalStop();
+    else
+        QMetaObject::invokeMethod(this, "internalStop", Qt::BlockingQueuedConnection);
+    RTeExecutor::instance()->release(m_executorThread);
+    m_executorThread = NULL;
+}
+
+//  internalStop() runs on the pool thread and hands the module back to its owner
+//  so that it doesn't keep the pool thread's affinity once released
+
+void RTeObjectModule::internalStop()
+{
+    stopModule();
+    if (m_executorThread != NULL)
+        moveToThread(m_ownerThread);
 }
@@ -35,11 +35,15 @@ public:
 
     //  resumeThread() is called when init is complete
 
-    virtual void resumeThread() { initModule(); }
+    virtual void resumeThread();
 
     //  exitThread is called to terminate and delete the thread
 
-    virtual void exitThread() { stopModule(); }
+    virtual void exitThread();
+
+public slots:
+    void internalInit() { initModule(); }
+    void internalStop();
 
 protected:
 
@@ -47,6 +51,10 @@ protected:
 
     virtual void initModule() = 0;                          // performs all module-specific initialization
     virtual void stopModule() = 0;                          // closes down module
+
+private:
+    QThread *m_executorThread;                              // the pool thread if on the executor
+    QThread *m_ownerThread;                                 // the thread the module goes back to when it stops
 };
 
 #endif // _RTEOBJECTMODULE_H_
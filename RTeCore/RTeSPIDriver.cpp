@@ -111,7 +111,7 @@ bool RTeSPIDriver::deviceRead(unsigned char bus, unsigned char select, unsigned
 
     if (ioctl(channel->m_fd, SPI_IOC_MESSAGE(1), &rdIOC) < 0) {
         if (strlen(errorMsg) > 0)
-            RTeError(m_logTag, QString("SPI read error from %1 - %2").arg(regAddr).arg(errorMsg));
+            RTeErrorLimited(m_logTag, QString("SPI read error from %1 - %2").arg(regAddr).arg(errorMsg));
         return false;
     }
     memcpy(data, rxBuff + 1, length);
@@ -197,11 +197,11 @@ bool RTeSPIDriver::internalDeviceWrite(RTESPIDRIVER_CHANNEL *channel, unsigned c
         result = ifWrite(channel, &regAddr, 1);
         if (result < 0) {
             if (strlen(errorMsg) > 0)
-                RTeError(m_logTag, QString("SPI write of regAddr failed - %1").arg(errorMsg));
+                RTeErrorLimited(m_logTag, QString("SPI write of regAddr failed - %1").arg(errorMsg));
             return false;
         } else if (result != 1) {
             if (strlen(errorMsg) > 0)
-                RTeError(m_logTag, QString("SPI write of regAddr failed (nothing written) - %1").arg(errorMsg));
+                RTeErrorLimited(m_logTag, QString("SPI write of regAddr failed (nothing written) - %1").arg(errorMsg));
             return false;
         }
     } else {
@@ -212,12 +212,12 @@ bool RTeSPIDriver::internalDeviceWrite(RTESPIDRIVER_CHANNEL *channel, unsigned c
 
         if (result < 0) {
             if (strlen(errorMsg) > 0)
-                RTeError(m_logTag, QString("SPI data write of %1 bytes failed - %2").arg(length).arg(errorMsg));
+                RTeErrorLimited(m_logTag, QString("SPI data write of %1 bytes failed - %2").arg(length).arg(errorMsg));
             return false;
         } else if (result < (int)length) {
             if (strlen(errorMsg) > 0)
-                RTeError(m_logTag, QString("SPI data write of %1 bytes failed, only %2 written - %3")
-                         .arg(length).arg(result).arg(errorMsg));
+                RTeErrorLimited(m_logTag, QString("SPI data write of %1 bytes failed, only %2 written - %3")
+                                .arg(length).arg(result).arg(errorMsg));
             return false;
         }
     }
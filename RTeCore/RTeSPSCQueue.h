@@ -0,0 +1,258 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTESPSCQUEUE_H_
+#define _RTESPSCQUEUE_H_
+
+#include <qglobal.h>
+#include <unistd.h>
+
+#define RTE_CACHE_LINE                  64                  // padding used to keep the two ends of a queue apart
+
+#define RTEQUEUE_BLOCK_POLL             100                 // uS between checks for space when blocking
+#define RTEQUEUE_BLOCK_TIMEOUT          100000              // default uS before a blocked push() drops the item
+
+//  What push() does when the queue is full. RTEQUEUE_BLOCK_WITH_TIMEOUT waits
+//  on the producer's thread, polling with usleep(), so it stalls acquisition
+//  while the consumer is behind. If there's still no space after the block
+//  timeout the item is dropped and counted, so that a stopped consumer can't
+//  hang the producer. Don't use it from a real time thread.
+
+typedef enum
+{
+    RTEQUEUE_DROP_NEWEST = 0,                               // discard the new item
+    RTEQUEUE_DROP_OLDEST,                                   // discard the oldest queued item
+    RTEQUEUE_BLOCK_WITH_TIMEOUT,                            // wait for space, drop after the block timeout
+    RTEQUEUE_COALESCE                                       // discard everything queued on every push
+} RTEQUEUE_POLICY;
+
+//  RTeSPSCQueue is a fixed size queue for passing items from one producer
+//  thread to one consumer thread without locks. All the storage is allocated
+//  by the constructor. Items discarded by the overflow policy are counted in
+//  overflows().
+//
+//  The producer's and consumer's indices are kept on separate cache lines so
+//  that the two threads don't keep invalidating each other's cache. Each side
+//  keeps a copy of the other's index and only re-reads the shared one when the
+//  copy says the queue is full (or empty).
+//
+//  With RTEQUEUE_DROP_OLDEST and RTEQUEUE_COALESCE the producer moves m_tail
+//  as well, so the consumer claims items with a compare and swap and retries
+//  if the producer got there first. T should be plain data as the consumer
+//  may copy an item that is being overwritten before it finds out.
+
+template <typename T>
+class RTeSPSCQueue
+{
+public:
+    //  capacity is rounded up to a power of two and then reduced until the
+    //  items fit in memoryLimit bytes (0 for no limit)
+
+    RTeSPSCQueue(int capacity = 1024, RTEQUEUE_POLICY policy = RTEQUEUE_DROP_NEWEST, int memoryLimit = 0)
+    {
+        for (m_capacity = 1; m_capacity < (quint32)capacity; m_capacity <<= 1)
+            ;
+        if (memoryLimit > 0) {
+            while ((m_capacity > 1) && (m_capacity * sizeof(T) > (quint32)memoryLimit))
+                m_capacity >>= 1;
+        }
+        m_mask = m_capacity - 1;
+        m_policy = policy;
+        m_items = new T[m_capacity];
+        m_head = m_tailCache = 0;
+        m_tail = m_headCache = 0;
+        m_overflows = 0;
+        m_blockTimeout = RTEQUEUE_BLOCK_TIMEOUT;
+    }
+
+    ~RTeSPSCQueue() { delete [] m_items; }
+
+    //  push() is only called by the producer. It returns false if the item was discarded.
+
+    bool push(const T& item)
+    {
+        T *slot = pushSlot();
+
+        if (slot == NULL)
+            return false;
+        *slot = item;
+        commitPush();
+        return true;
+    }
+
+    //  pushSlot() applies the policy and returns the slot for the next item so
+    //  that the producer can fill it in place, or NULL if the item has to be
+    //  discarded. The consumer can't see the item until commitPush() is called.
+
+    T *pushSlot()
+    {
+        quint32 head = m_head;
+
+        if (m_policy == RTEQUEUE_COALESCE)
+            discardAll(head);
+        else if (((head - m_tailCache) >= m_capacity) && !makeSpace(head))
+            return NULL;
+        return m_items + (head & m_mask);
+    }
+
+    void commitPush() { __atomic_store_n(&m_head, m_head + 1, __ATOMIC_RELEASE); }
+
+    //  pop() removes the oldest item. Only called by the consumer.
+
+    bool pop(T& item)
+    {
+        quint32 tail = __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+
+        while (1) {
+            if ((qint32)(m_headCache - tail) <= 0) {
+                m_headCache = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+                if (m_headCache == tail)
+                    return false;
+            }
+            item = m_items[tail & m_mask];
+            if (__atomic_compare_exchange_n(&m_tail, &tail, tail + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                return true;
+        }
+    }
+
+    //  takeLast() empties the queue and returns the newest item
+
+    bool takeLast(T& item)
+    {
+        quint32 tail = __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+
+        while (1) {
+            m_headCache = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+            if (m_headCache == tail)
+                return false;
+            item = m_items[(m_headCache - 1) & m_mask];
+            if (__atomic_compare_exchange_n(&m_tail, &tail, m_headCache, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                return true;
+        }
+    }
+
+    //  these can be called from either thread but are only a snapshot
+
+    int count() const
+        { return (int)(__atomic_load_n(&m_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE)); }
+    bool isEmpty() const { return count() == 0; }
+    int capacity() const { return (int)m_capacity; }
+    RTEQUEUE_POLICY policy() const { return m_policy; }
+
+    //  setBlockTimeout() sets how long RTEQUEUE_BLOCK_WITH_TIMEOUT waits in uS.
+    //  Call it before the producer starts.
+
+    void setBlockTimeout(int usecs) { m_blockTimeout = usecs; }
+    int blockTimeout() const { return m_blockTimeout; }
+    qint64 overflows() const { return __atomic_load_n(&m_overflows, __ATOMIC_RELAXED); }
+
+private:
+    //  no copying - the queue owns its storage
+
+    RTeSPSCQueue(const RTeSPSCQueue&);
+    RTeSPSCQueue& operator=(const RTeSPSCQueue&);
+
+    //  the consumer can't discard so this is only called by the producer, but
+    //  the add is atomic so that overflows() never sees a torn count
+
+    void addOverflows(quint32 count) { __atomic_fetch_add(&m_overflows, (qint64)count, __ATOMIC_RELAXED); }
+
+    //  makeSpace() applies the policy when the producer's copy of m_tail says
+    //  the queue is full. It returns false if the new item has to be discarded.
+
+    bool makeSpace(quint32 head)
+    {
+        int waited = 0;
+
+        while (1) {
+            m_tailCache = __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+            if ((head - m_tailCache) < m_capacity)
+                return true;
+
+            switch (m_policy) {
+            case RTEQUEUE_DROP_OLDEST:
+                //  if the swap fails the consumer has just made space
+
+                if (__atomic_compare_exchange_n(&m_tail, &m_tailCache, m_tailCache + 1, false,
+                                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                    m_tailCache++;
+                    addOverflows(1);
+                }
+                return true;
+
+            case RTEQUEUE_BLOCK_WITH_TIMEOUT:
+                if (waited < m_blockTimeout) {
+                    usleep(RTEQUEUE_BLOCK_POLL);
+                    waited += RTEQUEUE_BLOCK_POLL;
+                    continue;
+                }
+                addOverflows(1);
+                return false;
+
+            default:
+                addOverflows(1);
+                return false;
+            }
+        }
+    }
+
+    //  discardAll() empties the queue from the producer's side
+
+    void discardAll(quint32 head)
+    {
+        quint32 tail = __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+
+        while (tail != head) {
+            if (__atomic_compare_exchange_n(&m_tail, &tail, head, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                addOverflows(head - tail);
+                break;
+            }
+        }
+        m_tailCache = head;
+    }
+
+    T *m_items;
+    quint32 m_capacity;
+    quint32 m_mask;
+    RTEQUEUE_POLICY m_policy;
+    int m_blockTimeout;                                     // uS to wait with RTEQUEUE_BLOCK_WITH_TIMEOUT
+
+    char m_pad0[RTE_CACHE_LINE];
+
+    //  written by the producer
+
+    quint32 m_head;                                         // next slot to fill
+    quint32 m_tailCache;                                    // producer's copy of m_tail
+    qint64 m_overflows;                                     // items discarded by the overflow policy
+
+    char m_pad1[RTE_CACHE_LINE];
+
+    //  written by the consumer (and the producer when dropping)
+
+    quint32 m_tail;                                         // next slot to empty
+    quint32 m_headCache;                                    // consumer's copy of m_head
+
+    char m_pad2[RTE_CACHE_LINE];
+};
+
+#endif // _RTESPSCQUEUE_H_
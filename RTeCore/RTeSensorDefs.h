@@ -26,6 +26,8 @@
 
 #include "RTeMath.h"
 
+#include <string.h>
+
 //  All timestamps are uS since epoch
 
 //  Pressure sensor data
@@ -63,6 +65,40 @@ class RTeSensorAccelData
 public:
     RTeVector3 m_accel;                                     // in g
     qint64 m_timestamp;
+    qint64 m_timestampNs;                                   // nS on the source's timestamp clock
+};
+
+//  Accelerometer sample batch - a run of consecutive samples held as separate
+//  x, y, z and timestamp arrays so that consumers can work on whole blocks
+
+#define RTESENSOR_BATCH_SIZE            256                 // max samples in a batch
+
+class RTeSensorAccelBatch
+{
+public:
+    RTeSensorAccelBatch() { m_count = 0; }
+    RTeSensorAccelBatch(const RTeSensorAccelBatch& batch) { *this = batch; }
+
+    //  only the valid samples are copied - a batch is often far from full
+    //  and whole batches are copied through the connection queues
+
+    RTeSensorAccelBatch& operator=(const RTeSensorAccelBatch& batch)
+    {
+        m_count = batch.m_count;
+        memcpy(m_x, batch.m_x, m_count * sizeof(RTEFLOAT));
+        memcpy(m_y, batch.m_y, m_count * sizeof(RTEFLOAT));
+        memcpy(m_z, batch.m_z, m_count * sizeof(RTEFLOAT));
+        memcpy(m_timestamp, batch.m_timestamp, m_count * sizeof(qint64));
+        memcpy(m_timestampNs, batch.m_timestampNs, m_count * sizeof(qint64));
+        return *this;
+    }
+
+    RTEFLOAT m_x[RTESENSOR_BATCH_SIZE];                     // in g
+    RTEFLOAT m_y[RTESENSOR_BATCH_SIZE];
+    RTEFLOAT m_z[RTESENSOR_BATCH_SIZE];
+    qint64 m_timestamp[RTESENSOR_BATCH_SIZE];
+    qint64 m_timestampNs[RTESENSOR_BATCH_SIZE];             // nS on the source's timestamp clock
+    int m_count;                                            // number of valid samples
 };
 
 //  Magnetometer sensor data
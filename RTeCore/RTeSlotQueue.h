@@ -0,0 +1,243 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTESLOTQUEUE_H_
+#define _RTESLOTQUEUE_H_
+
+#include "RTeSPSCQueue.h"
+#include "RTeTripleBuffer.h"
+#include "RTeNotifier.h"
+#include "RTeLatencyHistogram.h"
+#include "RTeClock.h"
+
+#include <qstring.h>
+
+#define RTESLOTQUEUE_CAPACITY           1024                // default queue capacity
+#define RTESLOTQUEUE_MEMORY_LIMIT       (256 * 1024)        // default queue memory limit in bytes
+
+//  RTeSlotQueue carries the items from a module's signal, called on the
+//  module's thread, to the main loop. It is the member behind the generated
+//  <signal>_put(), <signal>_get() and <signal>_getLastOnly() slots.
+//
+//  By default it is a fixed size RTeSPSCQueue that never allocates after the
+//  first put. The capacity is limited by the memory limit so that large items
+//  get fewer entries. setType("latest") keeps only the newest item in an
+//  RTeTripleBuffer for consumers that only want the current state. No queue
+//  is built then and only getLastOnly() can be used.
+//
+//  The setters are generated from the connection's settings in the .edf
+//  (see RTeSlotQueue.dlg) and can be overridden in setup(). They must be
+//  called before the module is started.
+
+template <typename T>
+class RTeSlotQueue
+{
+public:
+    RTeSlotQueue()
+    {
+        m_latestOnly = false;
+        m_capacity = RTESLOTQUEUE_CAPACITY;
+        m_policy = RTEQUEUE_DROP_NEWEST;
+        m_memoryLimit = RTESLOTQUEUE_MEMORY_LIMIT;
+        m_blockTimeout = RTEQUEUE_BLOCK_TIMEOUT;
+        m_measureLatency = false;
+        m_notifier = NULL;
+        m_queue = NULL;
+        m_latest = NULL;
+        m_putSlot = NULL;
+    }
+
+    ~RTeSlotQueue()
+    {
+        delete m_queue;
+        delete m_latest;
+    }
+
+    //  setType() is "queue" (the default) or "latest"
+
+    void setType(const QString& type) { m_latestOnly = type == "latest"; }
+
+    //  the queue capacity, its memory limit in bytes (0 for none) and the policy
+    //  when it is full - "dropNewest", "dropOldest", "blockWithTimeout" or
+    //  "coalesce". setBlockTimeout() is in mS.
+
+    void setCapacity(const QString& capacity) { m_capacity = capacity.toInt(); }
+    void setMemoryLimit(const QString& limit) { m_memoryLimit = limit.toInt(); }
+    void setBlockTimeout(const QString& timeout) { m_blockTimeout = timeout.toInt() * 1000; }
+    void setPolicy(const QString& policy)
+    {
+        if (policy == "dropOldest")
+            m_policy = RTEQUEUE_DROP_OLDEST;
+        else if (policy == "blockWithTimeout")
+            m_policy = RTEQUEUE_BLOCK_WITH_TIMEOUT;
+        else if (policy == "coalesce")
+            m_policy = RTEQUEUE_COALESCE;
+        else
+            m_policy = RTEQUEUE_DROP_NEWEST;
+    }
+
+    //  setMeasureLatency("true") records the time from put to get
+
+    void setMeasureLatency(const QString& measure) { m_measureLatency = measure == "true"; }
+    void setLatencyName(const QString& name) { m_latency.setName(name); }
+
+    //  setNotifier() sets the notifier that put() wakes
+
+    void setNotifier(RTeNotifier *notifier) { m_notifier = notifier; }
+
+    //  put() is only called on the module's thread
+
+    void put(const T& item)
+    {
+        T *slot = beginPut();
+
+        if (slot == NULL)
+            return;
+        *slot = item;
+        endPut();
+    }
+
+    //  beginPut() returns the item to fill in place, saving a copy of large
+    //  items, or NULL if the policy discards it. A non NULL beginPut() must be
+    //  followed by endPut(), which makes the item visible to get().
+
+    T *beginPut()
+    {
+        if (m_latestOnly)
+            m_putSlot = latest()->beginPut();
+        else
+            m_putSlot = queue()->pushSlot();
+        return m_putSlot != NULL ? &m_putSlot->m_item : NULL;
+    }
+
+    void endPut()
+    {
+        m_putSlot->m_putTime = m_measureLatency ? RTeClock::currentNSecs(CLOCK_MONOTONIC) : 0;
+        if (m_latestOnly)
+            m_latest->endPut();
+        else
+            m_queue->commitPush();
+        if (m_notifier != NULL)
+            m_notifier->notify();
+    }
+
+    //  get() returns the oldest queued item. There's no queue with setType("latest").
+
+    bool get(T& item)
+    {
+        RTESLOTQUEUE_ITEM slotItem;
+        RTeSPSCQueue<RTESLOTQUEUE_ITEM> *queue = builtQueue();
+
+        Q_ASSERT_X(!m_latestOnly, "RTeSlotQueue::get", "latest only connections only support getLastOnly()");
+        if ((queue == NULL) || !queue->pop(slotItem))
+            return false;
+        return taken(slotItem, item);
+    }
+
+    //  getLastOnly() returns the newest item and discards any older ones
+
+    bool getLastOnly(T& item)
+    {
+        RTESLOTQUEUE_ITEM slotItem;
+        RTeSPSCQueue<RTESLOTQUEUE_ITEM> *queue;
+        RTeTripleBuffer<RTESLOTQUEUE_ITEM> *latest;
+
+        if (m_latestOnly) {
+            if (((latest = builtLatest()) == NULL) || !latest->getIfNew(slotItem))
+                return false;
+        } else if (((queue = builtQueue()) == NULL) || !queue->takeLast(slotItem)) {
+            return false;
+        }
+        return taken(slotItem, item);
+    }
+
+    bool isLatestOnly() const { return m_latestOnly; }
+    qint64 overflows() const
+    {
+        RTeSPSCQueue<RTESLOTQUEUE_ITEM> *queue = builtQueue();
+
+        return queue != NULL ? queue->overflows() : 0;
+    }
+    const RTeLatencyHistogram& latency() const { return m_latency; }
+
+private:
+    RTeSlotQueue(const RTeSlotQueue&);
+    RTeSlotQueue& operator=(const RTeSlotQueue&);
+
+    typedef struct
+    {
+        T m_item;
+        qint64 m_putTime;                                   // CLOCK_MONOTONIC time of the put
+    } RTESLOTQUEUE_ITEM;
+
+    //  queue() and latest() build the storage on the first put so that the
+    //  settings are final and only what the type needs is allocated. Only
+    //  called on the module's thread.
+
+    RTeSPSCQueue<RTESLOTQUEUE_ITEM> *queue()
+    {
+        if (m_queue == NULL) {
+            RTeSPSCQueue<RTESLOTQUEUE_ITEM> *queue =
+                    new RTeSPSCQueue<RTESLOTQUEUE_ITEM>(m_capacity, m_policy, m_memoryLimit);
+
+            queue->setBlockTimeout(m_blockTimeout);
+            __atomic_store_n(&m_queue, queue, __ATOMIC_RELEASE);
+        }
+        return m_queue;
+    }
+
+    RTeTripleBuffer<RTESLOTQUEUE_ITEM> *latest()
+    {
+        if (m_latest == NULL)
+            __atomic_store_n(&m_latest, new RTeTripleBuffer<RTESLOTQUEUE_ITEM>(), __ATOMIC_RELEASE);
+        return m_latest;
+    }
+
+    //  builtQueue() and builtLatest() are the consumer's view - NULL until the first put
+
+    RTeSPSCQueue<RTESLOTQUEUE_ITEM> *builtQueue() const { return __atomic_load_n(&m_queue, __ATOMIC_ACQUIRE); }
+    RTeTripleBuffer<RTESLOTQUEUE_ITEM> *builtLatest() const { return __atomic_load_n(&m_latest, __ATOMIC_ACQUIRE); }
+
+    bool taken(const RTESLOTQUEUE_ITEM& slotItem, T& item)
+    {
+        if (m_measureLatency)
+            m_latency.record(RTeClock::currentNSecs(CLOCK_MONOTONIC) - slotItem.m_putTime);
+        item = slotItem.m_item;
+        return true;
+    }
+
+    bool m_latestOnly;
+    int m_capacity;
+    RTEQUEUE_POLICY m_policy;
+    int m_memoryLimit;
+    int m_blockTimeout;                                     // in uS
+    bool m_measureLatency;
+
+    RTeSPSCQueue<RTESLOTQUEUE_ITEM> *m_queue;               // NULL until the first put
+    RTESLOTQUEUE_ITEM *m_putSlot;                           // the item between beginPut() and endPut()
+    RTeTripleBuffer<RTESLOTQUEUE_ITEM> *m_latest;           // NULL until the first put
+    RTeLatencyHistogram m_latency;                          // put to get
+    RTeNotifier *m_notifier;
+};
+
+#endif // _RTESLOTQUEUE_H_
@@ -22,18 +22,123 @@
 //  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "RTeThreadedModule.h"
+#include "RTeExecutor.h"
+
+#include <qstringlist.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
 
 RTeThreadedModule::RTeThreadedModule(QObject *parent) : RTeModule(parent)
 {
+    m_schedPolicy = "other";
+    m_schedPriority = 0;
+    m_lockMemory = false;
+    m_ownerThread = NULL;
 }
 
 void RTeThreadedModule::initThread()
 {
+    RTeLog::registerThread();
+
+    //  real time settings would affect every module sharing a pool thread
+
+    if (m_useExecutor) {
+        if ((m_schedPolicy != "other") || !m_cpuAffinity.isEmpty() || m_lockMemory)
+            RTeWarning(getModuleName(), "Real time settings are ignored for modules on the executor");
+    } else {
+        applyRealTime();
+    }
     initModule();
 }
 
+//  applyRealTime() runs in the module's thread so the settings apply to it alone
+//  (apart from the memory locking which is for the whole process)
+
+void RTeThreadedModule::applyRealTime()
+{
+    struct sched_param param;
+    int policy = SCHED_OTHER;
+    int err;
+
+    if (m_schedPolicy == "fifo")
+        policy = SCHED_FIFO;
+    else if (m_schedPolicy == "rr")
+        policy = SCHED_RR;
+    else if (m_schedPolicy != "other")
+        RTeWarning(getModuleName(), QString("Unknown scheduling policy ") + m_schedPolicy);
+
+    if (policy != SCHED_OTHER) {
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = qBound(sched_get_priority_min(policy), m_schedPriority, sched_get_priority_max(policy));
+        if ((err = pthread_setschedparam(pthread_self(), policy, &param)) != 0) {
+            if (err == EPERM)
+                RTeWarning(getModuleName(), QString("No permission for %1 priority %2 - needs root, CAP_SYS_NICE or an rtprio limit")
+                           .arg(m_schedPolicy).arg(param.sched_priority));
+            else
+                RTeError(getModuleName(), QString("Failed to set scheduling %1").arg(err));
+        } else {
+            RTeDebug(getModuleName(), QString("Scheduling %1 priority %2").arg(m_schedPolicy).arg(param.sched_priority));
+        }
+    }
+
+    if (!m_cpuAffinity.isEmpty()) {
+        cpu_set_t cpus;
+        QStringList ranges = m_cpuAffinity.split(",", QString::SkipEmptyParts);
+
+        CPU_ZERO(&cpus);
+        for (int i = 0; i < ranges.count(); i++) {
+            QStringList limits = ranges.at(i).split("-");
+            int first = limits.at(0).trimmed().toInt();
+            int last = limits.count() > 1 ? limits.at(1).trimmed().toInt() : first;
+
+            for (int cpu = first; (cpu <= last) && (cpu < CPU_SETSIZE); cpu++)
+                CPU_SET(cpu, &cpus);
+        }
+        if ((err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) != 0)
+            RTeError(getModuleName(), QString("Failed to set cpu affinity %1 (%2)").arg(m_cpuAffinity).arg(err));
+    }
+
+    if (m_lockMemory) {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+            if ((errno == EPERM) || (errno == ENOMEM))
+                RTeWarning(getModuleName(), "No permission to lock memory - needs root, CAP_IPC_LOCK or a memlock limit");
+            else
+                RTeError(getModuleName(), QString("Failed to lock memory %1").arg(errno));
+        }
+        prefaultStack();
+    }
+}
+
+//  prefaultStack() touches the stack the thread is expected to use so that
+//  the pages are mapped (and locked) before the real time work starts
+
+void RTeThreadedModule::prefaultStack()
+{
+    unsigned char stack[RTETHREADEDMODULE_STACK_PREFAULT];
+    volatile unsigned char *touch = stack;                  // volatile so the writes aren't optimized away
+
+    for (int i = 0; i < RTETHREADEDMODULE_STACK_PREFAULT; i += 1024)
+        touch[i] = 0;
+}
+
 void RTeThreadedModule::resumeThread()
 {
+    //  on the executor the thread is already running and is left running when the module ends
+
+    if (m_useExecutor) {
+        m_ownerThread = thread();
+        m_thread = RTeExecutor::instance()->acquire();
+        moveToThread(m_thread);
+        connect(this, SIGNAL(internalEndThread()), this, SLOT(cleanup()));
+        connect(this, SIGNAL(internalKillThread()), this, SLOT(releaseExecutor()));
+        QMetaObject::invokeMethod(this, "internalRunLoop", Qt::QueuedConnection);
+        return;
+    }
+
     m_thread = new QThread();
     moveToThread(m_thread);
     connect(m_thread, SIGNAL(started()), this, SLOT(internalRunLoop()));
@@ -44,6 +149,17 @@ void RTeThreadedModule::resumeThread()
     m_thread->start();
 }
 
+//  releaseExecutor() runs on the pool thread after cleanup(). The module is moved
+//  back to its owner before the pool thread is released so that the deleteLater()
+//  and anything queued to it afterwards don't run on the pool thread.
+
+void RTeThreadedModule::releaseExecutor()
+{
+    moveToThread(m_ownerThread);
+    RTeExecutor::instance()->release(m_thread);
+    deleteLater();
+}
+
 void RTeThreadedModule::finishThread()
 {
     stopModule();
@@ -27,6 +27,8 @@
 #include "RTeModule.h"
 #include <qthread.h>
 
+#define RTETHREADEDMODULE_STACK_PREFAULT    (64 * 1024)     // bytes of stack touched when memory is locked
+
 class RTeThreadedModule : public RTeModule
 {
     Q_OBJECT
@@ -42,11 +44,22 @@ public:
 
     virtual void exitThread() { emit internalEndThread(); }
 
+    //  real time settings, applied by the thread before initModule(). The policy
+    //  is "other" (the default), "fifo" or "rr" and the priority is 1 to 99 for
+    //  fifo and rr. The affinity is a list of cpus such as "1" or "0,2-3".
+    //  lockMemory locks all the process's memory and prefaults the thread's stack.
+
+    void setSchedPolicy(const QString& policy) { m_schedPolicy = policy; }
+    void setSchedPriority(const QString& priority) { m_schedPriority = priority.toInt(); }
+    void setCpuAffinity(const QString& cpus) { m_cpuAffinity = cpus; }
+    void setLockMemory(const QString& lock) { m_lockMemory = lock == "true"; }
+
 public slots:
     //	Qt threading stuff
 
     void internalRunLoop() { initThread(); emit running();}
     void cleanup() {finishThread(); emit internalKillThread(); }
+    void releaseExecutor();
 
 signals:
     //  Qt threading stuff
@@ -65,6 +78,17 @@ protected:
     virtual void stopModule() = 0;                          // closes down module
 
     QThread *m_thread;
+
+private:
+    QThread *m_ownerThread;                                 // the thread an executor module goes back to
+
+    void applyRealTime();
+    void prefaultStack();
+
+    QString m_schedPolicy;
+    int m_schedPriority;
+    QString m_cpuAffinity;
+    bool m_lockMemory;
 };
 
 #endif // _RTETHREADEDMODULE_H_
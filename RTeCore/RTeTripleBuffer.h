@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTETRIPLEBUFFER_H_
+#define _RTETRIPLEBUFFER_H_
+
+#include <qglobal.h>
+
+#define RTETRIPLEBUFFER_INDEX           3                   // mask for the buffer index in m_shared
+#define RTETRIPLEBUFFER_NEW             4                   // set in m_shared when it holds an unread value
+
+//  RTeTripleBuffer holds the latest value from one writer thread for one
+//  reader thread. Unlike RTeMailbox it suits large items. The writer and
+//  the reader each own a buffer and swap it with the third, shared one,
+//  so neither side ever waits or copies an item more than once.
+
+template <typename T>
+class RTeTripleBuffer
+{
+public:
+    RTeTripleBuffer() { m_write = 0; m_shared = 1; m_read = 2; }
+
+    //  put() is only called by the writer
+
+    void put(const T& item)
+    {
+        *beginPut() = item;
+        endPut();
+    }
+
+    //  beginPut() returns the writer's buffer to fill in place and endPut()
+    //  hands it to the reader
+
+    T *beginPut() { return m_buffers + m_write; }
+    void endPut()
+        { m_write = __atomic_exchange_n(&m_shared, m_write | RTETRIPLEBUFFER_NEW, __ATOMIC_ACQ_REL) & RTETRIPLEBUFFER_INDEX; }
+
+    //  getIfNew() returns the latest value if one has been put since the last
+    //  call. Only called by the reader.
+
+    bool getIfNew(T& item)
+    {
+        if ((__atomic_load_n(&m_shared, __ATOMIC_ACQUIRE) & RTETRIPLEBUFFER_NEW) == 0)
+            return false;
+        m_read = __atomic_exchange_n(&m_shared, m_read, __ATOMIC_ACQ_REL) & RTETRIPLEBUFFER_INDEX;
+        item = m_buffers[m_read];
+        return true;
+    }
+
+private:
+    RTeTripleBuffer(const RTeTripleBuffer&);
+    RTeTripleBuffer& operator=(const RTeTripleBuffer&);
+
+    T m_buffers[3];
+    int m_write;                                            // buffer owned by the writer
+    int m_shared;                                           // buffer being handed over, with RTETRIPLEBUFFER_NEW
+    int m_read;                                             // buffer owned by the reader
+};
+
+#endif // _RTETRIPLEBUFFER_H_
@@ -22,55 +22,586 @@
 //  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "RTeIIO.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <sys/eventfd.h>
+
+#include <qstringlist.h>
 
 RTeIIO::RTeIIO() : RTeThreadedModule()
 {
+    m_deviceRoot = "/";
     setDeviceNumber("0");
     m_useBuffer = true;
+    m_usePoll = true;
+    m_wakeupInterval = 10;
+    m_latencyBudget = 20;
+    m_optimizeLatency = false;
+    m_timestampClock = "monotonic_raw";
+    m_measureLatency = false;
+    m_readTime = 0;
+    m_kernelLatency.setName("kernel to read");
+    m_readLatency.setName("read to emit");
+    setExpectedRate(0);
+    m_stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_stagingBytes = 0;
+}
+
+RTeIIO::~RTeIIO()
+{
+    closeAttributes();
+    if (m_stopFd != -1)
+        close(m_stopFd);
+}
+
+void RTeIIO::exitThread()
+{
+    uint64_t one = 1;
+
+    //  the eventfd stays readable once written so a late waitForData() also returns
+
+    if (m_stopFd != -1) {
+        if (write(m_stopFd, &one, sizeof(one)) != sizeof(one))
+            RTeError(getModuleName(), QString("Failed to signal stop event %1").arg(errno));
+    }
+    RTeThreadedModule::exitThread();
+}
+
+bool RTeIIO::waitForData(int fd)
+{
+    struct pollfd fds[2];
+
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_stopFd;
+    fds[1].events = POLLIN;
+
+    while (1) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            RTeErrorLimited(getModuleName(), QString("Poll failed %1").arg(errno));
+            return false;
+        }
+
+        if (fds[1].revents & POLLIN)
+            return false;
+
+        if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            RTeErrorLimited(getModuleName(), QString("Poll error on iio device ") + m_deviceBuffer);
+            return false;
+        }
+
+        if (fds[0].revents & POLLIN)
+            return true;
+    }
+}
+
+bool RTeIIO::waitForStop(int msecs)
+{
+    struct pollfd fds;
+
+    fds.fd = m_stopFd;
+    fds.events = POLLIN;
+
+    while (poll(&fds, 1, msecs) < 0) {
+        if (errno != EINTR)
+            return true;
+    }
+    return (fds.revents & POLLIN) != 0;
 }
 
 void RTeIIO::setDeviceNumber(const QString &number)
 {
+    closeAttributes();
     m_deviceNumber = number.toInt();
-    m_devicePath = QString("/sys/bus/iio/devices/iio:device%1/").arg(m_deviceNumber);
-    m_deviceBuffer = QString("/dev/iio:device%1").arg(m_deviceNumber);
+    m_devicePath = m_deviceRoot + QString("sys/bus/iio/devices/iio:device%1/").arg(m_deviceNumber);
+    m_deviceBuffer = m_deviceRoot + QString("dev/iio:device%1").arg(m_deviceNumber);
 }
 
-bool RTeIIO::setValue(QString file, const QString &value)
+void RTeIIO::setDeviceRoot(const QString& root)
 {
-    QFile deviceFile(m_devicePath + file);
-    if (!deviceFile.open(QIODevice::WriteOnly))
+    m_deviceRoot = root;
+    if (!m_deviceRoot.endsWith("/"))
+        m_deviceRoot += "/";
+    setDeviceNumber(QString::number(m_deviceNumber));
+}
+
+int RTeIIO::readStaging(int fd)
+{
+    int count;
+
+    while (1) {
+        count = read(fd, m_staging + m_stagingBytes, RTEIIO_STAGING_SIZE - m_stagingBytes);
+
+        if (count >= 0) {
+            if (m_measureLatency)
+                m_readTime = RTeClock::currentNSecs(CLOCK_MONOTONIC);
+            break;
+        }
+
+        if (errno == EINTR)
+            continue;
+
+        if (errno == EAGAIN)
+            return 0;
+
+        RTeErrorLimited(getModuleName(), QString("Read failed %1").arg(errno));
+        return -1;
+    }
+
+    if ((count > 0) && m_capture.isOpen())
+        m_capture.write(m_clock.currentNSecs(), m_staging + m_stagingBytes, count);
+
+    m_stagingBytes += count;
+    return count;
+}
+
+void RTeIIO::consumeStaging(int bytes)
+{
+    if (bytes >= m_stagingBytes) {
+        m_stagingBytes = 0;
+        return;
+    }
+
+    m_stagingBytes -= bytes;
+    memmove(m_staging, m_staging + bytes, m_stagingBytes);
+}
+
+void RTeIIO::stopModule()
+{
+    stopCapture();
+    closeAttributes();
+    logLatency();
+}
+
+void RTeIIO::logLatency()
+{
+    if (!m_measureLatency)
+        return;
+    RTeInfo(getModuleName(), m_kernelLatency.display());
+    RTeInfo(getModuleName(), m_readLatency.display());
+}
+
+bool RTeIIO::startCapture(const RTeIIOScanLayout& layout, const QStringList& attributes)
+{
+    QMap<QString, QString> values;
+    QString value;
+
+    if (m_captureFile.isEmpty())
+        return true;
+
+    for (int i = 0; i < attributes.count(); i++) {
+        if (getValue(attributes.at(i), value))
+            values.insert(attributes.at(i), value);
+    }
+
+    if (!m_capture.open(m_captureFile, layout, m_clock.clockName(), m_clock.offset(), values))
+        return false;
+    RTeInfo(getModuleName(), QString("Capturing to ") + m_captureFile);
+    return true;
+}
+
+void RTeIIO::stopCapture()
+{
+    m_capture.close();
+}
+
+//  attributeFd() returns the cached fd for an attribute, opening it if necessary.
+//  Attributes are opened read/write if possible so that writes can be read back.
+
+int RTeIIO::attributeFd(const QString& file)
+{
+    QMap<QString, int>::const_iterator it = m_attributes.constFind(file);
+    int fd;
+
+    if (it != m_attributes.constEnd())
+        return it.value();
+
+    QByteArray path = (m_devicePath + file).toLocal8Bit();
+
+    if ((fd = open(path.constData(), O_RDWR | O_CLOEXEC)) == -1) {
+        if ((fd = open(path.constData(), O_WRONLY | O_CLOEXEC)) == -1) {
+            if ((fd = open(path.constData(), O_RDONLY | O_CLOEXEC)) == -1)
+                return -1;
+        }
+    }
+    m_attributes.insert(file, fd);
+    return fd;
+}
+
+void RTeIIO::closeAttributes()
+{
+    QMap<QString, int>::const_iterator it;
+
+    for (it = m_attributes.constBegin(); it != m_attributes.constEnd(); ++it)
+        close(it.value());
+    m_attributes.clear();
+}
+
+//  readAttribute() returns the first line - a sysfs attribute holds a single value
+
+bool RTeIIO::readAttribute(const QString& file, QString& value)
+{
+    char buf[RTEIIO_ATTRIBUTE_SIZE];
+    char *end;
+    int fd;
+    int count;
+
+    if ((fd = attributeFd(file)) == -1)
+        return false;
+
+    if ((count = pread(fd, buf, sizeof(buf) - 1, 0)) < 0)
         return false;
-    if (deviceFile.write(qPrintable(value)) < 0) {
-        deviceFile.close();
+    buf[count] = 0;
+    if ((end = strchr(buf, '\n')) != NULL)
+        *end = 0;
+    value = QString(buf).trimmed();
+    return true;
+}
+
+//  writeAttribute() sets applied to what the kernel reports after the write. If
+//  the attribute is write only, applied is the value written. The value is
+//  ended with a newline as echo does.
+
+bool RTeIIO::writeAttribute(const QString& file, const QString& value, QString& applied)
+{
+    QByteArray text = (value + "\n").toLocal8Bit();
+    int fd;
+
+    if ((fd = attributeFd(file)) == -1) {
+        applied = QString("open failed %1").arg(errno);
         return false;
     }
-    deviceFile.close();
+
+    if (pwrite(fd, text.constData(), text.length(), 0) != text.length()) {
+        applied = QString("write failed %1").arg(errno);
+        return false;
+    }
+
+    if (!readAttribute(file, applied))
+        applied = value;
     return true;
 }
 
-bool RTeIIO::setValue(QString file, int value)
+static bool attributeMatches(const QString& value, const QString& applied)
+{
+    bool valueOk, appliedOk;
+    qreal a = value.toDouble(&valueOk);
+    qreal b = applied.toDouble(&appliedOk);
+
+    if (!valueOk || !appliedOk)
+        return value == applied;
+
+    //  the kernel may print a different number of decimal places
+
+    return fabs(a - b) <= 1e-6 * (fabs(a) > 1.0 ? fabs(a) : 1.0);
+}
+
+bool RTeIIO::setValue(QString file, const QString &value)
 {
-    QFile deviceFile(m_devicePath + file);
-    if (!deviceFile.open(QIODevice::WriteOnly))
+    QString applied;
+
+    if (!writeAttribute(file, value, applied))
         return false;
-    if (deviceFile.write(qPrintable(QString::number(value))) < 0) {
-        deviceFile.close();
+    if (!attributeMatches(value, applied)) {
+        RTeWarning(getModuleName(), QString("%1 set to %2 but reads back %3").arg(file).arg(value).arg(applied));
         return false;
     }
-    deviceFile.close();
     return true;
 }
 
+bool RTeIIO::setValue(QString file, int value)
+{
+    return setValue(file, QString::number(value));
+}
+
 bool RTeIIO::setValue(QString file, qreal value)
 {
-    QFile deviceFile(m_devicePath + file);
-    if (!deviceFile.open(QIODevice::WriteOnly))
+    return setValue(file, QString::number(value));
+}
+
+bool RTeIIO::getValue(QString file, QString& value)
+{
+    if (!readAttribute(file, value))
         return false;
-    if (deviceFile.write(qPrintable(QString::number(value))) < 0) {
-        deviceFile.close();
+    return !value.isEmpty();
+}
+
+bool RTeIIO::getValue(QString file, qreal& value)
+{
+    QString text;
+    bool ok;
+
+    if (!getValue(file, text))
+        return false;
+    value = text.toDouble(&ok);
+    return ok;
+}
+
+bool RTeIIO::getValue(QString file, int& value)
+{
+    QString text;
+    bool ok;
+
+    if (!getValue(file, text))
+        return false;
+    value = text.toInt(&ok);
+    return ok;
+}
+
+bool RTeIIO::getAvailable(QString file, QList<qreal>& values)
+{
+    QString text;
+    QStringList entries;
+    bool ok;
+
+    values.clear();
+
+    if (!getValue(file, text) || text.startsWith("["))
+        return false;
+
+    entries = text.split(" ", QString::SkipEmptyParts);
+    for (int i = 0; i < entries.count(); i++) {
+        qreal value = entries.at(i).toDouble(&ok);
+        if (ok)
+            values.append(value);
+    }
+    return values.count() > 0;
+}
+
+bool RTeIIO::nearestAvailable(QString file, qreal target, qreal& nearest)
+{
+    QList<qreal> values;
+    QString text;
+    double min, step, max;
+
+    if (getAvailable(file, values)) {
+        nearest = values.at(0);
+        for (int i = 1; i < values.count(); i++) {
+            if (fabs(values.at(i) - target) < fabs(nearest - target))
+                nearest = values.at(i);
+        }
+        return true;
+    }
+
+    if (!getValue(file, text) || (sscanf(qPrintable(text), "[%lf %lf %lf]", &min, &step, &max) != 3))
+        return false;
+
+    if (target <= min)
+        nearest = min;
+    else if (target >= max)
+        nearest = max;
+    else if (step > 0)
+        nearest = min + floor((target - min) / step + 0.5) * step;
+    else
+        nearest = target;
+    return true;
+}
+
+bool RTeIIO::applySettings(const RTeIIOSettings& settings, QString& error)
+{
+    QString applied;
+
+    error.clear();
+
+    for (int i = 0; i < settings.count(); i++) {
+        if (!writeAttribute(settings.file(i), settings.value(i), applied) ||
+                !attributeMatches(settings.value(i), applied)) {
+            if (!error.isEmpty())
+                error += ", ";
+            error += QString("%1=%2 (%3)").arg(settings.file(i)).arg(settings.value(i)).arg(applied);
+        }
+    }
+    return error.isEmpty();
+}
+
+//  In throughput mode a wakeup handles the samples in one wakeup interval,
+//  limited by the latency budget and by RTEIIO_DECODE_BLOCK so that they
+//  normally fit in one batch. In latency mode it handles one sample.
+
+int RTeIIO::samplesPerWakeup(int rate)
+{
+    if (m_optimizeLatency || (rate <= 0))
+        return 1;
+    return qBound(1, qMin((rate * m_wakeupInterval) / 1000, (rate * m_latencyBudget) / 1000), RTEIIO_DECODE_BLOCK);
+}
+
+//  The kernel wakes a poll() on the buffer once watermark samples are available
+//  so the watermark is samplesPerWakeup(). If the device has a hardware fifo the
+//  watermark is kept within its limits so that the fifo is used rather than an
+//  interrupt per sample.
+
+void RTeIIO::tuneBuffer(int rate, RTeIIOSettings& settings)
+{
+    int watermark = samplesPerWakeup(rate);
+    int length;
+    int current;
+    int hwMin, hwMax;
+
+    if (getValue("buffer/hwfifo_watermark_min", hwMin) && getValue("buffer/hwfifo_watermark_max", hwMax)) {
+        if (watermark > hwMax)
+            watermark = hwMax;
+        if (watermark < hwMin) {
+            RTeDebug(getModuleName(), QString("Watermark %1 raised to the hardware fifo minimum %2").arg(watermark).arg(hwMin));
+            watermark = hwMin;
+        }
+    }
+
+    for (length = RTEIIO_MIN_BUFFER_LENGTH;
+            (length < watermark * RTEIIO_BUFFER_HEADROOM) && (length < RTEIIO_MAX_BUFFER_LENGTH); length *= 2)
+        ;
+
+    settings.add("buffer/length", length);
+
+    //  buffer/watermark only exists on newer kernels, it must be set after the length
+
+    if (getValue("buffer/watermark", current))
+        settings.add("buffer/watermark", watermark);
+    else
+        watermark = 1;
+
+    RTeDebug(getModuleName(), QString("Buffer length %1, watermark %2").arg(length).arg(watermark));
+}
+
+void RTeIIO::addTimestampClock(RTeIIOSettings& settings)
+{
+    QString current;
+
+    if (getValue("current_timestamp_clock", current))
+        settings.add("current_timestamp_clock", m_timestampClock);
+}
+
+void RTeIIO::readTimestampClock()
+{
+    QString current;
+
+    //  kernels without current_timestamp_clock always use realtime
+
+    if (!getValue("current_timestamp_clock", current))
+        current = "realtime";
+
+    if (!m_clock.setClock(current)) {
+        RTeWarning(getModuleName(), QString("Unknown timestamp clock %1, assuming realtime").arg(current));
+        m_clock.setClock("realtime");
+    }
+    RTeDebug(getModuleName(), QString("Using %1 timestamp clock").arg(m_clock.clockName()));
+}
+
+void RTeIIO::setExpectedRate(qreal rate)
+{
+    QMutexLocker lock(&m_sampleStatsLock);
+
+    m_expectedPeriod = rate > 0 ? (qint64)(1000000000.0 / rate) : 0;
+    m_lastSampleTimestamp = -1;
+    memset(&m_sampleStats, 0, sizeof(m_sampleStats));
+    m_rateEstimator.reset(rate);
+}
+
+RTEIIO_SAMPLE_STATS RTeIIO::getSampleStats()
+{
+    QMutexLocker lock(&m_sampleStatsLock);
+
+    return m_sampleStats;
+}
+
+qreal RTeIIO::getMeasuredRate() const
+{
+    QMutexLocker lock(&m_sampleStatsLock);
+
+    return m_rateEstimator.rate();
+}
+
+qreal RTeIIO::getDriftPPM() const
+{
+    QMutexLocker lock(&m_sampleStatsLock);
+
+    return m_rateEstimator.driftPPM();
+}
+
+void RTeIIO::addRateSamples(const qint64 *timestamps, int count)
+{
+    QMutexLocker lock(&m_sampleStatsLock);
+
+    m_rateEstimator.addSamples(timestamps, count);
+}
+
+bool RTeIIO::checkTimestamps(const qint64 *timestamps, int count)
+{
+    QMutexLocker lock(&m_sampleStatsLock);
+    qint64 problems = m_sampleStats.m_gaps + m_sampleStats.m_duplicates + m_sampleStats.m_reversals;
+    qint64 delta;
+    qint64 lost;
+
+    m_sampleStats.m_samples += count;
+
+    if (m_expectedPeriod <= 0) {
+        if (count > 0)
+            m_lastSampleTimestamp = timestamps[count - 1];
         return false;
     }
-    deviceFile.close();
+
+    for (int i = 0; i < count; i++) {
+        if (m_lastSampleTimestamp >= 0) {
+            delta = timestamps[i] - m_lastSampleTimestamp;
+
+            if (delta < 0) {
+                m_sampleStats.m_reversals++;
+            } else if (delta < m_expectedPeriod / 4) {
+                m_sampleStats.m_duplicates++;
+            } else if (delta > m_expectedPeriod + m_expectedPeriod / 2) {
+                lost = (delta + m_expectedPeriod / 2) / m_expectedPeriod - 1;
+                m_sampleStats.m_gaps++;
+                m_sampleStats.m_lostSamples += lost;
+                m_rateEstimator.addLostPeriods(lost);
+            }
+        }
+        m_lastSampleTimestamp = timestamps[i];
+    }
+
+    return (m_sampleStats.m_gaps + m_sampleStats.m_duplicates + m_sampleStats.m_reversals) != problems;
+}
+
+int RTeIIO::openAttribute(const QString& file)
+{
+    int fd = open(qPrintable(m_devicePath + file), O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1)
+        RTeError(getModuleName(), QString("Failed to open ") + m_devicePath + file);
+    return fd;
+}
+
+bool RTeIIO::readAttribute(int fd, int& value)
+{
+    char buf[32];
+    int count;
+    int i = 0;
+    bool negative = false;
+    int result = 0;
+
+    //  sysfs regenerates the attribute on every read from offset 0
+
+    if ((count = pread(fd, buf, sizeof(buf) - 1, 0)) <= 0)
+        return false;
+    buf[count] = 0;
+
+    while ((buf[i] == ' ') || (buf[i] == '\t'))
+        i++;
+
+    if ((buf[i] == '-') || (buf[i] == '+'))
+        negative = buf[i++] == '-';
+
+    if ((buf[i] < '0') || (buf[i] > '9'))
+        return false;
+
+    for (; (buf[i] >= '0') && (buf[i] <= '9'); i++)
+        result = result * 10 + (buf[i] - '0');
+
+    value = negative ? -result : result;
     return true;
 }
@@ -27,31 +27,259 @@
 
 #include "RTeThreadedModule.h"
 #include "RTeSensorDefs.h"
+#include "RTeClock.h"
+#include "RTeIIOCapture.h"
+#include "RTeLatencyHistogram.h"
 
 #include <qfile.h>
+#include <qlist.h>
+#include <qmap.h>
+#include <qmutex.h>
+#include <qstringlist.h>
+
+#define RTEIIO_STAGING_SIZE             16384               // max bytes taken from the buffer per read()
+#define RTEIIO_ATTRIBUTE_SIZE           4096                // max size of a sysfs attribute
+
+#define RTEIIO_MIN_BUFFER_LENGTH        128                 // smallest kernel buffer length used
+#define RTEIIO_MAX_BUFFER_LENGTH        65536               // largest kernel buffer length used
+#define RTEIIO_BUFFER_HEADROOM          4                   // buffer length as a multiple of the watermark
+
+//  RTEIIO_SAMPLE_STATS counts the problems found in the buffer timestamps.
+//  A gap is a step of more than 1.5 sample periods, a duplicate is a step of
+//  less than a quarter of a period and a reversal is a step backwards.
+
+typedef struct
+{
+    qint64 m_samples;                                       // samples checked
+    qint64 m_gaps;                                          // number of gaps
+    qint64 m_lostSamples;                                   // samples missing in the gaps
+    qint64 m_duplicates;                                    // samples too close to the previous one
+    qint64 m_reversals;                                     // samples earlier than the previous one
+} RTEIIO_SAMPLE_STATS;
+
+//  RTeIIOSettings collects attribute writes so that they can be applied as a
+//  group by RTeIIO::applySettings(). Entries are written in the order added.
+
+class RTeIIOSettings
+{
+public:
+    void add(const QString& file, int value) { add(file, QString::number(value)); }
+    void add(const QString& file, qreal value) { add(file, QString::number(value)); }
+    void add(const QString& file, const QString& value) { m_files.append(file); m_values.append(value); }
+
+    int count() const { return m_files.count(); }
+    const QString& file(int i) const { return m_files.at(i); }
+    const QString& value(int i) const { return m_values.at(i); }
+
+private:
+    QList<QString> m_files;
+    QList<QString> m_values;
+};
 
 class RTeIIO : public RTeThreadedModule
 {
 public:
     RTeIIO();
+    virtual ~RTeIIO();
 
     void setDeviceNumber(const QString& number);
+
+    //  setDeviceRoot() moves the sysfs and /dev trees under another directory,
+    //  for example to use a simulated device. The default is "/".
+
+    void setDeviceRoot(const QString& root);
     void setUseBuffer(const QString& useBuffer) { m_useBuffer = useBuffer == "true"; }
+    void setUsePoll(const QString& usePoll) { m_usePoll = usePoll == "true"; }
+
+    //  buffer tuning - the wakeup interval and latency budget are in mS, the
+    //  mode is "throughput" (batch up to the interval) or "latency" (wake per sample)
+
+    void setWakeupInterval(const QString& interval) { m_wakeupInterval = interval.toInt(); }
+    void setLatencyBudget(const QString& budget) { m_latencyBudget = budget.toInt(); }
+    void setBufferMode(const QString& mode) { m_optimizeLatency = mode == "latency"; }
+
+    //  setTimestampClock() selects the kernel clock used for buffer timestamps,
+    //  for example "monotonic_raw" (the default) or "boottime"
+
+    void setTimestampClock(const QString& clock) { m_timestampClock = clock; }
+
+    //  setCaptureFile() records every buffer read to a file that can be replayed later
+
+    void setCaptureFile(const QString& path) { m_captureFile = path; }
+
+    //  the sample rate actually measured from the timestamps and its error from nominal
+
+    qreal getMeasuredRate() const;
+    qreal getDriftPPM() const;
+
+    //  getSampleStats() returns the sample loss counters since the module started
+
+    RTEIIO_SAMPLE_STATS getSampleStats();
+
+    //  setMeasureLatency("true") records how long samples wait in the kernel
+    //  buffer (kernel timestamp to read) and how long decoding takes (read to
+    //  emit). The histograms can be read at any time and are logged at shutdown.
+
+    void setMeasureLatency(const QString& measure) { m_measureLatency = measure == "true"; }
+    const RTeLatencyHistogram& getKernelLatency() const { return m_kernelLatency; }
+    const RTeLatencyHistogram& getReadLatency() const { return m_readLatency; }
+
+    //  exitThread() also wakes up any thread blocked in waitForData()
+
+    virtual void exitThread();
 
 protected:
+    //  stopModule() stops the capture, closes the cached attribute fds and logs
+    //  the latency histograms. Derived modules call it after closing their own files.
+
+    virtual void stopModule();
+
+    //  waitForData() blocks in poll() until fd is readable. It returns false
+    //  if the stop event was signalled or the poll failed.
+
+    bool waitForData(int fd);
+
+    //  waitForStop() waits up to msecs for the stop event. It returns true if it was signalled.
+
+    bool waitForStop(int msecs);
+
+    //  readStaging() appends whatever the kernel has available (up to the free space)
+    //  to m_staging. It returns the number of bytes read, 0 if there was nothing
+    //  to read or -1 on error. m_readTime is set as soon as read() returns when
+    //  latency is being measured.
+
+    int readStaging(int fd);
+
+    //  consumeStaging() discards bytes from the front of m_staging. Any partial
+    //  scan left behind is moved to the start, ready for the next read.
+
+    void consumeStaging(int bytes);
+
+    //  startCapture() opens the capture file if one was set. The header records
+    //  the layout, the timestamp clock and the current values of attributes.
+
+    bool startCapture(const RTeIIOScanLayout& layout, const QStringList& attributes);
+    void stopCapture();
+
+    //  setValue() writes an attribute and reads it back. It returns false if the
+    //  write failed or the kernel holds a different value afterwards.
+
     bool setValue(QString file, int value);
     bool setValue(QString file, qreal value);
     bool setValue(QString file, const QString& value);
 
+    bool getValue(QString file, QString& value);
+    bool getValue(QString file, qreal& value);
+    bool getValue(QString file, int& value);
+
+    //  getAvailable() reads a space separated *_available list. Ranges in the
+    //  "[min step max]" form are not lists and return false.
+
+    bool getAvailable(QString file, QList<qreal>& values);
+
+    //  nearestAvailable() finds the value closest to target in a *_available
+    //  attribute. "[min step max]" ranges are rounded to the nearest step.
+
+    bool nearestAvailable(QString file, qreal target, qreal& nearest);
+
+    //  applySettings() writes all the settings in order and verifies each one.
+    //  Failures don't stop the sequence, they are collected into error.
+
+    bool applySettings(const RTeIIOSettings& settings, QString& error);
+
+    //  samplesPerWakeup() is the number of samples to handle per wakeup at rate
+    //  for the buffer mode, wakeup interval and latency budget
+
+    int samplesPerWakeup(int rate);
+
+    //  tuneBuffer() adds buffer/length and (if supported) buffer/watermark
+    //  settings chosen for the sample rate, wakeup interval and latency budget
+
+    void tuneBuffer(int rate, RTeIIOSettings& settings);
+
+    //  addTimestampClock() adds the current_timestamp_clock setting if the kernel
+    //  supports it. readTimestampClock() then sets m_clock to match the device.
+
+    void addTimestampClock(RTeIIOSettings& settings);
+    void readTimestampClock();
+
+    //  setExpectedRate() sets the rate used to check timestamps and clears the counters
+
+    void setExpectedRate(qreal rate);
+
+    //  checkTimestamps() updates the sample stats from a block of nS timestamps.
+    //  It returns true if any gaps, duplicates or reversals were found.
+
+    bool checkTimestamps(const qint64 *timestamps, int count);
+
+    //  addRateSamples() feeds the rate estimator from the acquisition thread
+
+    void addRateSamples(const qint64 *timestamps, int count);
+
+    //  closeAttributes() closes all the cached attribute fds
+
+    void closeAttributes();
+
+    //  logLatency() logs the latency histograms if they are being measured
+
+    void logLatency();
+
+    //  openAttribute() opens a sysfs attribute once so that it can be read
+    //  repeatedly with readAttribute(). It returns the fd or -1 on error.
+
+    int openAttribute(const QString& file);
+
+    //  readAttribute() re-reads an open attribute from the start and parses it
+    //  as an integer without allocating
+
+    static bool readAttribute(int fd, int& value);
+
+private:
+    int attributeFd(const QString& file);
+    bool writeAttribute(const QString& file, const QString& value, QString& applied);
+    bool readAttribute(const QString& file, QString& value);
+
+    QMap<QString, int> m_attributes;                        // cached fds indexed by file
+
+protected:
+
     qint64 m_timestamp;
 
     QString m_devicePath;                                   // base path for device
 
     int m_timer;
     int m_deviceNumber;                                     // the iio device number
+    QString m_deviceRoot;                                   // directory containing sys/ and dev/
     QString m_deviceBuffer;                                 // buffer device
 
     bool m_useBuffer;
+    bool m_usePoll;                                         // true to block on the buffer rather than use a timer
+
+    int m_wakeupInterval;                                   // target time between wakeups in mS
+    int m_latencyBudget;                                    // max time a sample may wait in the buffer in mS
+    bool m_optimizeLatency;                                 // true to wake for every sample
+
+    int m_stopFd;                                           // eventfd used to end waitForData()
+
+    QString m_timestampClock;                               // requested timestamp clock name
+    RTeClock m_clock;                                       // the clock the device is using
+    RTeRateEstimator m_rateEstimator;                       // measures the real sample rate
+
+    bool m_measureLatency;                                  // true to record the latency histograms
+    RTeLatencyHistogram m_kernelLatency;                    // kernel timestamp to read()
+    RTeLatencyHistogram m_readLatency;                      // read() to emit
+    qint64 m_readTime;                                      // CLOCK_MONOTONIC nS when the last read() returned
+
+    QString m_captureFile;                                  // file to record buffer reads to, empty for none
+    RTeIIOCaptureWriter m_capture;
+
+    qint64 m_expectedPeriod;                                // nS between samples, 0 if unknown
+    qint64 m_lastSampleTimestamp;                           // nS timestamp of the last sample checked
+    RTEIIO_SAMPLE_STATS m_sampleStats;
+    mutable QMutex m_sampleStatsLock;                       // guards the stats and the rate estimator
+
+    unsigned char m_staging[RTEIIO_STAGING_SIZE];           // raw scans read from the buffer
+    int m_stagingBytes;                                     // number of valid bytes in m_staging
 };
 
 #endif // _RTEIIO_H
@@ -25,6 +25,10 @@ INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
 
 HEADERS += $$PWD/RTeIIO.h \
+    $$PWD/RTeIIOScan.h \
+    $$PWD/RTeIIOCapture.h \
 
 SOURCES += $$PWD/RTeIIO.cpp \
+    $$PWD/RTeIIOScan.cpp \
+    $$PWD/RTeIIOCapture.cpp \
 
@@ -0,0 +1,288 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RTeIIOCapture.h"
+#include "RTeLog.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+
+#include <qstringlist.h>
+
+RTeIIOCaptureWriter::RTeIIOCaptureWriter()
+{
+    m_fd = -1;
+    m_stop = false;
+    m_ring = NULL;
+    m_head = 0;
+    m_tail = 0;
+    m_used = 0;
+    m_droppedRecords = 0;
+}
+
+RTeIIOCaptureWriter::~RTeIIOCaptureWriter()
+{
+    close();
+}
+
+bool RTeIIOCaptureWriter::open(const QString& path, const RTeIIOScanLayout& layout, const QString& clockName,
+                               qint64 epochOffset, const QMap<QString, QString>& attributes)
+{
+    QString header;
+    QMap<QString, QString>::const_iterator it;
+
+    close();
+
+    header = QString(RTEIIO_CAPTURE_MAGIC) + "\n";
+    header += QString("clock %1\n").arg(clockName);
+    header += QString("epoch %1\n").arg(epochOffset);
+    for (int i = 0; i < layout.channelCount(); i++) {
+        const RTEIIO_CHANNEL& channel = layout.channel(i);
+        header += QString("channel %1 %2 %3\n").arg(channel.m_name).arg(channel.m_index)
+                .arg(RTeIIOScanLayout::typeString(channel));
+    }
+    for (it = attributes.constBegin(); it != attributes.constEnd(); ++it)
+        header += QString("attr %1 %2\n").arg(it.key()).arg(it.value());
+    header += "end\n";
+
+    QByteArray text = header.toLatin1();
+
+    if ((m_fd = ::open(qPrintable(path), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) == -1) {
+        RTeError("capture", QString("Failed to create capture file ") + path);
+        return false;
+    }
+
+    if (::write(m_fd, text.constData(), text.length()) != text.length()) {
+        RTeError("capture", QString("Failed to write capture header %1").arg(errno));
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    m_ring = new unsigned char[RTEIIO_CAPTURE_RING_SIZE];
+    m_head = m_tail = m_used = 0;
+    m_droppedRecords = 0;
+    m_stop = false;
+    start();
+    return true;
+}
+
+void RTeIIOCaptureWriter::close()
+{
+    if (m_fd == -1)
+        return;
+
+    m_lock.lock();
+    m_stop = true;
+    m_wake.wakeOne();
+    m_lock.unlock();
+    wait();
+
+    ::close(m_fd);
+    m_fd = -1;
+    delete [] m_ring;
+    m_ring = NULL;
+
+    if (m_droppedRecords > 0)
+        RTeWarning("capture", QString("%1 records dropped from capture").arg(m_droppedRecords));
+}
+
+void RTeIIOCaptureWriter::write(qint64 captureTime, const unsigned char *data, int length)
+{
+    unsigned char header[RTEIIO_CAPTURE_RECORD_HEADER];
+    qint32 recordLength = length;
+
+    if ((m_fd == -1) || (length <= 0))
+        return;
+
+    memcpy(header, &captureTime, sizeof(captureTime));
+    memcpy(header + sizeof(captureTime), &recordLength, sizeof(recordLength));
+
+    QMutexLocker lock(&m_lock);
+
+    //  records are kept whole so a full ring drops the entire read
+
+    if (m_used + RTEIIO_CAPTURE_RECORD_HEADER + length > RTEIIO_CAPTURE_RING_SIZE) {
+        m_droppedRecords++;
+        return;
+    }
+    queue(header, RTEIIO_CAPTURE_RECORD_HEADER);
+    queue(data, length);
+    m_wake.wakeOne();
+}
+
+void RTeIIOCaptureWriter::queue(const unsigned char *data, int length)
+{
+    int part = RTEIIO_CAPTURE_RING_SIZE - m_head;
+
+    if (part > length)
+        part = length;
+    memcpy(m_ring + m_head, data, part);
+    memcpy(m_ring, data + part, length - part);
+    m_head = (m_head + length) % RTEIIO_CAPTURE_RING_SIZE;
+    m_used += length;
+}
+
+//  run() writes out the ring. The lock is not held during the write as write()
+//  only ever adds bytes after m_head and this thread is the only one moving m_tail.
+
+void RTeIIOCaptureWriter::run()
+{
+    int length;
+    int written;
+
+    m_lock.lock();
+    while (1) {
+        while ((m_used == 0) && !m_stop)
+            m_wake.wait(&m_lock);
+
+        if (m_used == 0)
+            break;
+
+        length = m_used;
+        if (m_tail + length > RTEIIO_CAPTURE_RING_SIZE)
+            length = RTEIIO_CAPTURE_RING_SIZE - m_tail;
+        m_lock.unlock();
+
+        written = ::write(m_fd, m_ring + m_tail, length);
+
+        m_lock.lock();
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            RTeErrorLimited("capture", QString("Capture write failed %1").arg(errno));
+            m_used = 0;
+            m_tail = m_head;
+            m_stop = true;
+            break;
+        }
+        m_tail = (m_tail + written) % RTEIIO_CAPTURE_RING_SIZE;
+        m_used -= written;
+    }
+    m_lock.unlock();
+}
+
+RTeIIOCaptureReader::RTeIIOCaptureReader()
+{
+    m_clockName = "realtime";
+    m_epochOffset = 0;
+}
+
+bool RTeIIOCaptureReader::open(const QString& path)
+{
+    QString line;
+    QStringList fields;
+    int pos;
+
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        RTeError("capture", QString("Failed to open capture file ") + path);
+        return false;
+    }
+
+    if (QString(m_file.readLine()).trimmed() != RTEIIO_CAPTURE_MAGIC) {
+        RTeError("capture", path + " is not a capture file");
+        close();
+        return false;
+    }
+
+    while (1) {
+        line = QString(m_file.readLine()).trimmed();
+        if (line.isEmpty()) {
+            RTeError("capture", QString("Capture header truncated in ") + path);
+            close();
+            return false;
+        }
+        if (line == "end")
+            break;
+
+        fields = line.split(" ");
+        if ((fields.at(0) == "clock") && (fields.count() == 2)) {
+            m_clockName = fields.at(1);
+        } else if ((fields.at(0) == "epoch") && (fields.count() == 2)) {
+            m_epochOffset = fields.at(1).toLongLong();
+        } else if ((fields.at(0) == "channel") && (fields.count() == 4)) {
+            if (!m_layout.addChannel(fields.at(1), fields.at(2).toInt(), fields.at(3))) {
+                RTeError("capture", QString("Bad channel in capture header: ") + line);
+                close();
+                return false;
+            }
+        } else if ((fields.at(0) == "attr") && (fields.count() >= 3)) {
+            //  values may contain spaces
+
+            pos = line.indexOf(' ', 5);
+            m_attributes.insert(fields.at(1), line.mid(pos + 1));
+        }
+    }
+
+    if (m_layout.channelCount() == 0) {
+        RTeError("capture", QString("No channels in ") + path);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void RTeIIOCaptureReader::close()
+{
+    if (m_file.isOpen())
+        m_file.close();
+    m_layout.clear();
+    m_attributes.clear();
+    m_clockName = "realtime";
+    m_epochOffset = 0;
+}
+
+bool RTeIIOCaptureReader::attribute(const QString& file, QString& value) const
+{
+    QMap<QString, QString>::const_iterator it = m_attributes.constFind(file);
+
+    if (it == m_attributes.constEnd())
+        return false;
+    value = it.value();
+    return true;
+}
+
+int RTeIIOCaptureReader::readRecord(qint64& captureTime, unsigned char *data, int maxLength)
+{
+    unsigned char header[RTEIIO_CAPTURE_RECORD_HEADER];
+    qint32 length;
+    qint64 count;
+
+    if ((count = m_file.read((char *)header, RTEIIO_CAPTURE_RECORD_HEADER)) == 0)
+        return 0;
+    if (count != RTEIIO_CAPTURE_RECORD_HEADER)
+        return -1;
+
+    memcpy(&captureTime, header, sizeof(captureTime));
+    memcpy(&length, header + sizeof(captureTime), sizeof(length));
+
+    if ((length <= 0) || (length > maxLength))
+        return -1;
+    if (m_file.read((char *)data, length) != length)
+        return -1;
+    return length;
+}
@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTEIIOCAPTURE_H
+#define	_RTEIIOCAPTURE_H
+
+#include "RTeIIOScan.h"
+
+#include <qthread.h>
+#include <qmutex.h>
+#include <qwaitcondition.h>
+#include <qfile.h>
+#include <qmap.h>
+
+#define RTEIIO_CAPTURE_MAGIC            "RTeIIOCapture 1"
+#define RTEIIO_CAPTURE_RING_SIZE        (1024 * 1024)       // bytes queued for the writer thread
+#define RTEIIO_CAPTURE_RECORD_HEADER    12                  // qint64 capture time + qint32 length
+
+//  A capture file starts with a text header:
+//
+//      RTeIIOCapture 1
+//      clock <timestamp clock name>
+//      epoch <nS to add to clock timestamps to get the epoch>
+//      channel <name> <index> <type>           (one per enabled scan element)
+//      attr <file> <value>                     (sysfs configuration)
+//      end
+//
+//  followed by one binary record per read() of the buffer: the capture time in
+//  nS on the timestamp clock, the length and then the raw scan bytes exactly as
+//  read. Numbers in records are in host byte order.
+
+//  RTeIIOCaptureWriter records buffer reads without blocking the acquisition
+//  thread. write() copies into a ring that a background thread drains to the
+//  file. If the ring is full the record is dropped and counted.
+
+class RTeIIOCaptureWriter : public QThread
+{
+public:
+    RTeIIOCaptureWriter();
+    virtual ~RTeIIOCaptureWriter();
+
+    //  open() creates the file, writes the header and starts the writer thread
+
+    bool open(const QString& path, const RTeIIOScanLayout& layout, const QString& clockName,
+              qint64 epochOffset, const QMap<QString, QString>& attributes);
+
+    //  write() queues one record. It never waits for the disk.
+
+    void write(qint64 captureTime, const unsigned char *data, int length);
+
+    //  close() writes out everything queued and stops the thread
+
+    void close();
+
+    bool isOpen() const { return m_fd != -1; }
+    qint64 droppedRecords() const { return m_droppedRecords; }
+
+protected:
+    void run();
+
+private:
+    void queue(const unsigned char *data, int length);
+
+    int m_fd;
+    QMutex m_lock;
+    QWaitCondition m_wake;
+    bool m_stop;
+
+    unsigned char *m_ring;
+    int m_head;                                             // next byte written by write()
+    int m_tail;                                             // next byte written to the file
+    int m_used;                                             // bytes in the ring
+    qint64 m_droppedRecords;
+};
+
+//  RTeIIOCaptureReader reads back a capture file
+
+class RTeIIOCaptureReader
+{
+public:
+    RTeIIOCaptureReader();
+
+    //  open() reads the header. The layout, clock and attributes are then available.
+
+    bool open(const QString& path);
+    void close();
+
+    const RTeIIOScanLayout& layout() const { return m_layout; }
+    const QString& clockName() const { return m_clockName; }
+    qint64 epochOffset() const { return m_epochOffset; }
+    bool attribute(const QString& file, QString& value) const;
+
+    //  readRecord() reads the next record into data. It returns the length,
+    //  0 at the end of the file or -1 if the record is bad or larger than maxLength.
+
+    int readRecord(qint64& captureTime, unsigned char *data, int maxLength);
+
+private:
+    QFile m_file;
+    RTeIIOScanLayout m_layout;
+    QString m_clockName;
+    qint64 m_epochOffset;
+    QMap<QString, QString> m_attributes;
+};
+
+#endif // _RTEIIOCAPTURE_H
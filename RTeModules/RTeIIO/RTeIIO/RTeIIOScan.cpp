@@ -0,0 +1,406 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RTeIIOScan.h"
+#include "RTeConvert.h"
+
+#include <qdir.h>
+#include <qfile.h>
+#include <qstringlist.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define RTEIIO_HOST_BIG_ENDIAN          true
+#else
+#define RTEIIO_HOST_BIG_ENDIAN          false
+#endif
+
+static bool readScanElement(const QString& path, QString& value)
+{
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    value = QString(file.readAll()).trimmed();
+    file.close();
+    return true;
+}
+
+//----------------------------------------------------------
+//
+//  The RTeIIOScanLayout class
+
+RTeIIOScanLayout::RTeIIOScanLayout()
+{
+    clear();
+}
+
+void RTeIIOScanLayout::clear()
+{
+    m_channels.clear();
+    m_scanSize = 0;
+}
+
+bool RTeIIOScanLayout::load(const QString& scanElementsPath)
+{
+    QDir dir(scanElementsPath);
+    QStringList filter;
+    QString value;
+    QString name;
+    QString type;
+    bool ok;
+
+    clear();
+
+    filter << "*_en";
+    QStringList enables = dir.entryList(filter, QDir::Files);
+
+    for (int i = 0; i < enables.count(); i++) {
+        if (!readScanElement(scanElementsPath + enables.at(i), value) || (value != "1"))
+            continue;
+
+        name = enables.at(i).left(enables.at(i).length() - 3);
+
+        if (!readScanElement(scanElementsPath + name + "_index", value))
+            return false;
+        int index = value.toInt(&ok);
+        if (!ok)
+            return false;
+
+        if (!readScanElement(scanElementsPath + name + "_type", type))
+            return false;
+
+        if (!addChannel(name, index, type))
+            return false;
+    }
+    return m_channels.count() > 0;
+}
+
+bool RTeIIOScanLayout::addChannel(const QString& name, int index, const QString& type)
+{
+    RTEIIO_CHANNEL channel;
+    int pos;
+
+    channel.m_name = name;
+    channel.m_index = index;
+    if (!parseType(type, channel))
+        return false;
+
+    //  keep the list sorted by scan index
+
+    for (pos = 0; pos < m_channels.count(); pos++) {
+        if (m_channels.at(pos).m_index > index)
+            break;
+    }
+    m_channels.insert(pos, channel);
+    computeOffsets();
+    return true;
+}
+
+int RTeIIOScanLayout::findChannel(const QString& name) const
+{
+    for (int i = 0; i < m_channels.count(); i++) {
+        if (m_channels.at(i).m_name == name)
+            return i;
+    }
+    return -1;
+}
+
+//  parseType() decodes strings of the form [be|le]:[s|u]bits/storagebits[Xrepeat]>>shift
+
+bool RTeIIOScanLayout::parseType(const QString& type, RTEIIO_CHANNEL& channel)
+{
+    QByteArray text = type.trimmed().toLatin1();
+    char endian[3];
+    char sign;
+    unsigned int bits;
+    unsigned int storageBits;
+    unsigned int repeat = 1;
+    unsigned int shift = 0;
+
+    if (sscanf(text.constData(), "%2c:%c%u/%uX%u>>%u", endian, &sign, &bits, &storageBits, &repeat, &shift) != 6) {
+        repeat = 1;
+        shift = 0;
+        if (sscanf(text.constData(), "%2c:%c%u/%u>>%u", endian, &sign, &bits, &storageBits, &shift) < 4)
+            return false;
+    }
+    endian[2] = 0;
+
+    if ((strcmp(endian, "le") != 0) && (strcmp(endian, "be") != 0))
+        return false;
+    if ((sign != 's') && (sign != 'u'))
+        return false;
+    if ((storageBits != 8) && (storageBits != 16) && (storageBits != 32) && (storageBits != 64))
+        return false;
+    if ((bits == 0) || (bits + shift > storageBits) || (repeat == 0))
+        return false;
+
+    channel.m_bigEndian = endian[0] == 'b';
+    channel.m_signed = sign == 's';
+    channel.m_bits = bits;
+    channel.m_storageBytes = storageBits / 8;
+    channel.m_repeat = repeat;
+    channel.m_shift = shift;
+    channel.m_offset = 0;
+    return true;
+}
+
+//  computeOffsets() follows the kernel rules (iio_compute_scan_bytes()): every
+//  channel is aligned to its total size, the storage size times the repeat
+//  count, and the whole scan is padded to the largest total size
+
+void RTeIIOScanLayout::computeOffsets()
+{
+    int offset = 0;
+    int largest = 1;
+
+    for (int i = 0; i < m_channels.count(); i++) {
+        RTEIIO_CHANNEL& channel = m_channels[i];
+        int size = channel.m_storageBytes * channel.m_repeat;
+
+        if (offset % size)
+            offset += size - (offset % size);
+        channel.m_offset = offset;
+        offset += size;
+        if (size > largest)
+            largest = size;
+    }
+
+    if (offset % largest)
+        offset += largest - (offset % largest);
+    m_scanSize = offset;
+}
+
+qint64 RTeIIOScanLayout::decodeChannel(const unsigned char *scan, const RTEIIO_CHANNEL& channel)
+{
+    const unsigned char *data = scan + channel.m_offset;
+    uint64_t value = 0;
+    int i;
+
+    if (channel.m_bigEndian) {
+        for (i = 0; i < channel.m_storageBytes; i++)
+            value = (value << 8) | data[i];
+    } else {
+        for (i = channel.m_storageBytes - 1; i >= 0; i--)
+            value = (value << 8) | data[i];
+    }
+
+    value >>= channel.m_shift;
+
+    if (channel.m_bits < 64) {
+        uint64_t mask = ((uint64_t)1 << channel.m_bits) - 1;
+
+        value &= mask;
+        if (channel.m_signed && (value & ((uint64_t)1 << (channel.m_bits - 1))))
+            value |= ~mask;
+    }
+    return (qint64)value;
+}
+
+void RTeIIOScanLayout::encodeChannel(unsigned char *scan, const RTEIIO_CHANNEL& channel, qint64 value)
+{
+    unsigned char *data = scan + channel.m_offset;
+    uint64_t raw = (uint64_t)value;
+    int i;
+
+    if (channel.m_bits < 64)
+        raw &= ((uint64_t)1 << channel.m_bits) - 1;
+    raw <<= channel.m_shift;
+
+    if (channel.m_bigEndian) {
+        for (i = channel.m_storageBytes - 1; i >= 0; i--, raw >>= 8)
+            data[i] = raw & 0xff;
+    } else {
+        for (i = 0; i < channel.m_storageBytes; i++, raw >>= 8)
+            data[i] = raw & 0xff;
+    }
+}
+
+QString RTeIIOScanLayout::display() const
+{
+    QString result = QString("scan size %1:").arg(m_scanSize);
+
+    for (int i = 0; i < m_channels.count(); i++) {
+        const RTEIIO_CHANNEL& channel = m_channels.at(i);
+        result += QString(" %1@%2(%3)").arg(channel.m_name).arg(channel.m_offset).arg(typeString(channel));
+    }
+    return result;
+}
+
+QString RTeIIOScanLayout::typeString(const RTEIIO_CHANNEL& channel)
+{
+    QString repeat;
+
+    if (channel.m_repeat > 1)
+        repeat = QString("X%1").arg(channel.m_repeat);
+
+    return QString("%1%2%3/%4%5>>%6").arg(channel.m_bigEndian ? "be:" : "le:").arg(channel.m_signed ? "s" : "u")
+            .arg(channel.m_bits).arg(channel.m_storageBytes * 8).arg(repeat).arg(channel.m_shift);
+}
+
+//----------------------------------------------------------
+//
+//  The RTeIIOTripletDecoder class
+
+RTeIIOTripletDecoder::RTeIIOTripletDecoder()
+{
+    m_decoder = decodeGeneral;
+    m_timestamp.m_offset = -1;
+    m_nativeTimestamp = false;
+    m_scale = 1;
+    m_scanSize = 0;
+}
+
+bool RTeIIOTripletDecoder::setup(const RTeIIOScanLayout& layout, const QString& prefix, RTEFLOAT scale)
+{
+    static const char *axisNames[3] = {"_x", "_y", "_z"};
+    int pos;
+
+    m_scanSize = layout.scanSize();
+    m_scale = scale;
+    m_decoder = decodeGeneral;
+
+    for (int i = 0; i < 3; i++) {
+        if ((pos = layout.findChannel(prefix + axisNames[i])) < 0)
+            return false;
+        m_axes[i] = layout.channel(pos);
+    }
+
+    if ((pos = layout.findChannel("in_timestamp")) >= 0) {
+        m_timestamp = layout.channel(pos);
+        m_nativeTimestamp = (m_timestamp.m_storageBytes == 8) && (m_timestamp.m_bits == 64) &&
+                (m_timestamp.m_shift == 0) && (m_timestamp.m_bigEndian == RTEIIO_HOST_BIG_ENDIAN);
+    } else {
+        m_timestamp.m_offset = -1;
+        m_nativeTimestamp = false;
+    }
+
+    //  see if one of the specialized decoders fits - the axes must be signed
+    //  16 bit values with the same endianness and shift, the data bits filling the
+    //  rest of the storage so that an arithmetic shift does the sign extension
+
+    for (int i = 0; i < 3; i++) {
+        const RTEIIO_CHANNEL& axis = m_axes[i];
+
+        if ((axis.m_storageBytes != 2) || !axis.m_signed || (axis.m_repeat != 1) ||
+                (axis.m_bits + axis.m_shift != 16) ||
+                (axis.m_bigEndian != m_axes[0].m_bigEndian) || (axis.m_shift != m_axes[0].m_shift))
+            return true;
+    }
+
+    if ((m_axes[1].m_offset == m_axes[0].m_offset + 2) && (m_axes[2].m_offset == m_axes[0].m_offset + 4)) {
+        m_decoder = decodeTriplets;
+        return true;
+    }
+
+    if (m_axes[0].m_bigEndian) {
+        switch (m_axes[0].m_shift) {
+        case 0: m_decoder = decodeS16<true, 0>; break;
+        case 4: m_decoder = decodeS16<true, 4>; break;
+        }
+    } else {
+        switch (m_axes[0].m_shift) {
+        case 0: m_decoder = decodeS16<false, 0>; break;
+        case 4: m_decoder = decodeS16<false, 4>; break;
+        }
+    }
+    return true;
+}
+
+void RTeIIOTripletDecoder::decodeTimestamps(const RTeIIOTripletDecoder& dec, const unsigned char *data, int count,
+                                            qint64 *timestamp)
+{
+    int i;
+
+    if (dec.m_timestamp.m_offset < 0) {
+        for (i = 0; i < count; i++)
+            timestamp[i] = 0;
+    } else if (dec.m_nativeTimestamp) {
+        for (i = 0; i < count; i++, data += dec.m_scanSize)
+            memcpy(timestamp + i, data + dec.m_timestamp.m_offset, sizeof(qint64));
+    } else {
+        for (i = 0; i < count; i++, data += dec.m_scanSize)
+            timestamp[i] = RTeIIOScanLayout::decodeChannel(data, dec.m_timestamp);
+    }
+}
+
+template <bool bigEndian, int shift>
+void RTeIIOTripletDecoder::decodeS16(const RTeIIOTripletDecoder& dec, const unsigned char *data, int count,
+                                     RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z, qint64 *timestamp)
+{
+    const unsigned char *scan = data;
+    const int offsetX = dec.m_axes[0].m_offset;
+    const int offsetY = dec.m_axes[1].m_offset;
+    const int offsetZ = dec.m_axes[2].m_offset;
+    const RTEFLOAT scale = dec.m_scale;
+    uint16_t raw[3];
+
+    for (int i = 0; i < count; i++, scan += dec.m_scanSize) {
+        memcpy(raw + 0, scan + offsetX, 2);
+        memcpy(raw + 1, scan + offsetY, 2);
+        memcpy(raw + 2, scan + offsetZ, 2);
+
+        if (bigEndian != RTEIIO_HOST_BIG_ENDIAN) {
+            raw[0] = __builtin_bswap16(raw[0]);
+            raw[1] = __builtin_bswap16(raw[1]);
+            raw[2] = __builtin_bswap16(raw[2]);
+        }
+
+        x[i] = (RTEFLOAT)((int16_t)raw[0] >> shift) * scale;
+        y[i] = (RTEFLOAT)((int16_t)raw[1] >> shift) * scale;
+        z[i] = (RTEFLOAT)((int16_t)raw[2] >> shift) * scale;
+    }
+    decodeTimestamps(dec, data, count, timestamp);
+}
+
+void RTeIIOTripletDecoder::decodeTriplets(const RTeIIOTripletDecoder& dec, const unsigned char *data, int count,
+                                          RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z, qint64 *timestamp)
+{
+    RTeConvert::tripletsToSoA(data + dec.m_axes[0].m_offset, dec.m_scanSize, count, dec.m_axes[0].m_bigEndian,
+                              dec.m_axes[0].m_shift, dec.m_scale, x, y, z);
+    decodeTimestamps(dec, data, count, timestamp);
+}
+
+void RTeIIOTripletDecoder::decodeGeneral(const RTeIIOTripletDecoder& dec, const unsigned char *data, int count,
+                                         RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z, qint64 *timestamp)
+{
+    const unsigned char *scan = data;
+
+    for (int i = 0; i < count; i++, scan += dec.m_scanSize) {
+        x[i] = (RTEFLOAT)RTeIIOScanLayout::decodeChannel(scan, dec.m_axes[0]) * dec.m_scale;
+        y[i] = (RTEFLOAT)RTeIIOScanLayout::decodeChannel(scan, dec.m_axes[1]) * dec.m_scale;
+        z[i] = (RTEFLOAT)RTeIIOScanLayout::decodeChannel(scan, dec.m_axes[2]) * dec.m_scale;
+    }
+    decodeTimestamps(dec, data, count, timestamp);
+}
+
+QString RTeIIOTripletDecoder::decoderName() const
+{
+    if (m_decoder == decodeGeneral)
+        return "general decoder";
+    if (m_decoder == decodeTriplets)
+        return QString("%1 triplet decoder").arg(RTeConvert::kernelName(RTeConvert::kernel()));
+    return "specialized decoder";
+}
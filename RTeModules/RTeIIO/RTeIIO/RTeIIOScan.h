@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTEIIOSCAN_H
+#define	_RTEIIOSCAN_H
+
+#include "RTeSensorDefs.h"
+
+#include <qlist.h>
+#include <qstring.h>
+
+#define RTEIIO_DECODE_BLOCK             RTESENSOR_BATCH_SIZE // max scans converted per decode() call
+
+//  RTEIIO_CHANNEL describes one channel of a buffer scan. The type fields come
+//  from the scan_elements *_type file, for example "le:s12/16>>4".
+
+typedef struct
+{
+    QString m_name;                                         // channel name, e.g. in_accel_x
+    int m_index;                                            // position in the scan (from *_index)
+    bool m_bigEndian;                                       // true if "be"
+    bool m_signed;                                          // true if "s"
+    int m_bits;                                             // valid bits
+    int m_storageBytes;                                     // bytes used to store one value
+    int m_repeat;                                           // number of values (normally 1)
+    int m_shift;                                            // right shift to apply after reading
+    int m_offset;                                           // byte offset of the channel within the scan
+} RTEIIO_CHANNEL;
+
+//  RTeIIOScanLayout holds the enabled channels and works out where each one
+//  sits in a scan, including the alignment padding that the kernel inserts
+
+class RTeIIOScanLayout
+{
+public:
+    RTeIIOScanLayout();
+
+    //  load() reads the enabled channels from a scan_elements directory
+
+    bool load(const QString& scanElementsPath);
+
+    //  addChannel() adds a channel from its index and type string
+
+    bool addChannel(const QString& name, int index, const QString& type);
+
+    void clear();
+
+    //  findChannel() returns the position of the named channel in the layout or -1
+
+    int findChannel(const QString& name) const;
+
+    int channelCount() const { return m_channels.count(); }
+    const RTEIIO_CHANNEL& channel(int i) const { return m_channels.at(i); }
+    int scanSize() const { return m_scanSize; }
+
+    QString display() const;
+
+    static bool parseType(const QString& type, RTEIIO_CHANNEL& channel);
+
+    //  typeString() is the reverse of parseType()
+
+    static QString typeString(const RTEIIO_CHANNEL& channel);
+
+    //  decodeChannel() is the general case that handles any endianness, size, shift and sign
+
+    static qint64 decodeChannel(const unsigned char *scan, const RTEIIO_CHANNEL& channel);
+
+    //  encodeChannel() is the reverse of decodeChannel(), used to generate scans
+
+    static void encodeChannel(unsigned char *scan, const RTEIIO_CHANNEL& channel, qint64 value);
+
+private:
+    void computeOffsets();
+
+    QList<RTEIIO_CHANNEL> m_channels;                       // sorted by scan index
+    int m_scanSize;                                         // bytes per scan including padding
+};
+
+//  RTeIIOTripletDecoder converts the three axis channels (and the timestamp if
+//  enabled) of a block of scans into scaled values. setup() selects a
+//  specialized decoder for common layouts and the general one for anything else.
+//  Signed 16 bit axes stored next to each other use the RTeConvert SIMD kernels.
+
+class RTeIIOTripletDecoder
+{
+public:
+    RTeIIOTripletDecoder();
+
+    //  setup() finds <prefix>_x, <prefix>_y, <prefix>_z and in_timestamp in the layout
+
+    bool setup(const RTeIIOScanLayout& layout, const QString& prefix, RTEFLOAT scale);
+
+    //  decode() converts count scans (up to RTEIIO_DECODE_BLOCK) starting at data.
+    //  Timestamps are the raw kernel values, or 0 if there is no timestamp channel.
+
+    inline void decode(const unsigned char *data, int count, RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z,
+                       qint64 *timestamp) const
+        { (*m_decoder)(*this, data, count, x, y, z, timestamp); }
+
+    int scanSize() const { return m_scanSize; }
+    bool hasTimestamp() const { return m_timestamp.m_offset >= 0; }
+    bool isSpecialized() const { return m_decoder != decodeGeneral; }
+    QString decoderName() const;
+
+private:
+    typedef void (*RTEIIO_DECODER)(const RTeIIOTripletDecoder&, const unsigned char *, int,
+                                   RTEFLOAT *, RTEFLOAT *, RTEFLOAT *, qint64 *);
+
+    template <bool bigEndian, int shift>
+    static void decodeS16(const RTeIIOTripletDecoder& dec, const unsigned char *data, int count,
+                          RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z, qint64 *timestamp);
+
+    static void decodeTriplets(const RTeIIOTripletDecoder& dec, const unsigned char *data, int count,
+                               RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z, qint64 *timestamp);
+
+    static void decodeGeneral(const RTeIIOTripletDecoder& dec, const unsigned char *data, int count,
+                              RTEFLOAT *x, RTEFLOAT *y, RTEFLOAT *z, qint64 *timestamp);
+
+    static void decodeTimestamps(const RTeIIOTripletDecoder& dec, const unsigned char *data, int count,
+                                 qint64 *timestamp);
+
+    RTEIIO_DECODER m_decoder;
+
+    RTEIIO_CHANNEL m_axes[3];
+    RTEIIO_CHANNEL m_timestamp;                             // m_offset is -1 if not present
+    bool m_nativeTimestamp;                                 // true if timestamp can be copied directly
+    RTEFLOAT m_scale;
+    int m_scanSize;
+};
+
+#endif // _RTEIIOSCAN_H
@@ -26,6 +26,8 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <math.h>
+#include <stdio.h>
 
 RTeIIOAccel::RTeIIOAccel() : RTeIIO()
 {
@@ -34,52 +36,81 @@ RTeIIOAccel::RTeIIOAccel() : RTeIIO()
     m_dataNames[2] = "in_accel_z_raw";
     m_count = 0;
     m_fp = -1;
+    for (int i = 0; i < 3; i++)
+        m_rawFds[i] = -1;
+    m_rawScale = 1;
+    m_rate = 25;
+    m_sysfsBlock = 1;
     m_timer = -1;
     m_sampleRate = 2;
+    m_fsr = 0;
+    m_broadcast = NULL;
+}
+
+RTeIIOAccel::~RTeIIOAccel()
+{
+    delete m_broadcast;
+}
+
+void RTeIIOAccel::setBroadcastSize(const QString& size)
+{
+    delete m_broadcast;
+    m_broadcast = size.toInt() > 0 ? new RTeBroadcastRing<RTeSensorAccelData>(size.toInt()) : NULL;
 }
 
 
 void RTeIIOAccel::initModule()
 {
-    int rate;
+    RTeIIOSettings settings;
+    QString error;
+    qreal rate;
+
+    //  pollLoop() never returns so it can't share a pool thread
 
-    if (!setValue("buffer/enable", 0)) {
-        RTeError(getModuleName(), "Failed to disable buffer");
+    if (m_useExecutor && m_usePoll) {
+        RTeWarning(getModuleName(), "Poll mode blocks so the timer is used on the executor");
+        m_usePoll = false;
     }
 
-    switch (m_sampleRate) {
-    case 0: rate = 1; break;
-    case 1: rate = 10; break;
-    case 2: rate = 25; break;
-    case 3: rate = 50; break;
-    case 4: rate = 100; break;
-    case 5: rate = 200; break;
-    case 6: rate = 400; break;
-    case 7: rate = 1600; break;
-    default: rate = 25; break;
+    m_rate = requestedRate();
+    if (nearestAvailable("sampling_frequency_available", m_rate, rate)) {
+        m_rate = rate;
+    } else if (m_sampleRate == RTEIIOACCEL_RATE_MAX) {
+        RTeWarning(getModuleName(), "Device doesn't list its rates, using 1600Hz");
+        m_rate = 1600;
     }
 
-    setValue("sampling_frequency", rate);
+    //  the buffer must be disabled while the configuration is changed
+
+    settings.add("buffer/enable", 0);
+    settings.add("sampling_frequency", m_rate);
+    addScale(settings);
+    addTimestampClock(settings);
 
     if (m_useBuffer) {
-        if (!setValue("scan_elements/in_accel_x_en", 1)) {
-            RTeError(getModuleName(), "Failed enable x axis");
-        }
-        if (!setValue("scan_elements/in_accel_y_en", 1)) {
-            RTeError(getModuleName(), "Failed enable y axis");
-        }
-        if (!setValue("scan_elements/in_accel_z_en", 1)) {
-            RTeError(getModuleName(), "Failed enable z axis");
-        }
-        if (!setValue("scan_elements/in_timestamp_en", 1)) {
-            RTeError(getModuleName(), "Failed enable timestamp");
-        }
-        if (!setValue("buffer/length", 128)) {
-            RTeError(getModuleName(), "Failed to set buffer length");
-        }
-        if (!setValue("buffer/enable", 1)) {
-            RTeError(getModuleName(), "Failed to enable buffer");
-        }
+        settings.add("scan_elements/in_accel_x_en", 1);
+        settings.add("scan_elements/in_accel_y_en", 1);
+        settings.add("scan_elements/in_accel_z_en", 1);
+        settings.add("scan_elements/in_timestamp_en", 1);
+        tuneBuffer((int)ceil(m_rate), settings);
+        settings.add("buffer/enable", 1);
+    }
+
+    if (!applySettings(settings, error))
+        RTeError(getModuleName(), QString("Failed to configure device: ") + error);
+
+    readTimestampClock();
+
+    //  the rate the kernel accepted is what the timestamps will be checked against
+
+    if (getValue("sampling_frequency", rate) && (rate > 0))
+        m_rate = rate;
+    setExpectedRate(m_rate);
+    RTeDebug(getModuleName(), QString("Sample rate %1Hz").arg(m_rate));
+
+    if (m_useBuffer) {
+        if (!setupDecoder())
+            return;
 
         m_fp = open(qPrintable(m_deviceBuffer), O_RDONLY | O_NONBLOCK);
 
@@ -87,81 +118,365 @@ void RTeIIOAccel::initModule()
             RTeError(getModuleName(), QString("Failed to open iio device ") + m_deviceBuffer);
             return;
         }
-        m_bytesLeft = sizeof(RTEIIOACCEL_DATA);
-        m_bytesGot = 0;
+        m_stagingBytes = 0;
+
+        QStringList attributes;
+        attributes << "name" << "sampling_frequency" << "in_accel_scale" << "in_accel_x_scale"
+                   << "current_timestamp_clock" << "buffer/length" << "buffer/watermark";
+        startCapture(m_layout, attributes);
+    } else {
+        if (!openRawFiles())
+            return;
     }
 
-    m_timer = startTimer(2);
     m_startTime = RTeMath::currentUSecsSinceEpoch();
+
+    //  in poll mode the loop is queued so that initModule() returns and running() is emitted
+
+    if (!m_useBuffer) {
+        m_batch.m_count = 0;
+        m_sysfsBlock = samplesPerWakeup((int)ceil(m_rate));
+        m_timer = startTimer(1000.0 / m_rate > 1 ? (int)(1000.0 / m_rate) : 1);
+    } else if (m_usePoll)
+        QMetaObject::invokeMethod(this, "pollLoop", Qt::QueuedConnection);
+    else
+        m_timer = startTimer(2);
+}
+
+qreal RTeIIOAccel::requestedRate()
+{
+    switch (m_sampleRate) {
+    case 0: return 1;
+    case 1: return 10;
+    case 2: return 25;
+    case 3: return 50;
+    case 4: return 100;
+    case 5: return 200;
+    case 6: return 400;
+    case 7: return 1600;
+    case RTEIIOACCEL_RATE_MAX: return 1e9;
+    default: return 25;
+    }
+}
+
+//  addScale() picks the finest in_accel_scale whose range covers m_fsr, or the
+//  coarsest if none does. The range is the largest raw value times the scale.
+
+void RTeIIOAccel::addScale(RTeIIOSettings& settings)
+{
+    QList<qreal> scales;
+    QString type;
+    RTEIIO_CHANNEL xAxis;
+    bool perAxis = false;
+    qreal maxRaw = 32767;
+    qreal best = -1;
+    qreal coarsest = -1;
+
+    if (m_fsr <= 0)
+        return;
+
+    if (!getAvailable("in_accel_scale_available", scales)) {
+        if (!getAvailable("in_accel_x_scale_available", scales)) {
+            RTeWarning(getModuleName(), "Device doesn't list its scales, FSR ignored");
+            return;
+        }
+        perAxis = true;
+    }
+
+    if (getValue("scan_elements/in_accel_x_type", type) && RTeIIOScanLayout::parseType(type, xAxis))
+        maxRaw = pow(2.0, xAxis.m_bits - (xAxis.m_signed ? 1 : 0)) - 1;
+
+    for (int i = 0; i < scales.count(); i++) {
+        qreal scale = scales.at(i);
+
+        if ((scale * maxRaw / RTEIIOACCEL_GRAVITY >= m_fsr) && ((best < 0) || (scale < best)))
+            best = scale;
+        if (scale > coarsest)
+            coarsest = scale;
+    }
+    if (best < 0) {
+        RTeWarning(getModuleName(), QString("FSR %1g not supported, using %2g")
+                   .arg(m_fsr).arg(coarsest * maxRaw / RTEIIOACCEL_GRAVITY, 0, 'f', 1));
+        best = coarsest;
+    }
+
+    if (perAxis) {
+        settings.add("in_accel_x_scale", best);
+        settings.add("in_accel_y_scale", best);
+        settings.add("in_accel_z_scale", best);
+    } else {
+        settings.add("in_accel_scale", best);
+    }
+}
+
+//  openRawFiles() opens the in_accel_*_raw files once for sysfs polling
+
+bool RTeIIOAccel::openRawFiles()
+{
+    qreal scale;
+
+    for (int i = 0; i < 3; i++) {
+        if ((m_rawFds[i] = openAttribute(m_dataNames[i])) == -1) {
+            closeRawFiles();
+            return false;
+        }
+    }
+
+    if (getValue("in_accel_scale", scale) || getValue("in_accel_x_scale", scale))
+        m_rawScale = scale / RTEIIOACCEL_GRAVITY;
+    else
+        m_rawScale = 1.0 / 1000.0;
+    return true;
+}
+
+void RTeIIOAccel::closeRawFiles()
+{
+    for (int i = 0; i < 3; i++) {
+        if (m_rawFds[i] != -1) {
+            close(m_rawFds[i]);
+            m_rawFds[i] = -1;
+        }
+    }
+}
+
+//  setupDecoder() builds the scan layout from scan_elements. If that can't be read
+//  the layout of the LSM303DLHC (three le:s16 axes and a timestamp) is assumed.
+
+bool RTeIIOAccel::setupDecoder()
+{
+    qreal scale;
+
+    if (!m_layout.load(m_devicePath + "scan_elements/")) {
+        RTeWarning(getModuleName(), "Failed to read scan_elements, using default layout");
+        m_layout.clear();
+        m_layout.addChannel("in_accel_x", 0, "le:s16/16>>0");
+        m_layout.addChannel("in_accel_y", 1, "le:s16/16>>0");
+        m_layout.addChannel("in_accel_z", 2, "le:s16/16>>0");
+        m_layout.addChannel("in_timestamp", 3, "le:s64/64>>0");
+    }
+
+    if (!getValue("in_accel_scale", scale) && !getValue("in_accel_x_scale", scale))
+        scale = 0;
+    return setupDecoder(scale);
+}
+
+bool RTeIIOAccel::setupDecoder(qreal scale)
+{
+    RTEIIO_CHANNEL xAxis;
+
+    int pos = m_layout.findChannel("in_accel_x");
+    if (pos < 0) {
+        RTeError(getModuleName(), "No accel channels in scan layout");
+        return false;
+    }
+    xAxis = m_layout.channel(pos);
+
+    //  the kernel scale converts shifted raw values to m/s^2. Without it, fall back
+    //  to 16384 per g for the unshifted value as the LSM303DLHC at +/-2g gives.
+
+    if (scale > 0)
+        scale /= RTEIIOACCEL_GRAVITY;
+    else
+        scale = (qreal)(1 << xAxis.m_shift) / 16384.0;
+
+    if (!m_decoder.setup(m_layout, "in_accel", (RTEFLOAT)scale)) {
+        RTeError(getModuleName(), "Scan layout does not contain x, y and z axes");
+        return false;
+    }
+
+    RTeDebug(getModuleName(), m_layout.display() + " (" + m_decoder.decoderName() + ")");
+    return true;
 }
 
 void RTeIIOAccel::stopModule()
 {
-    if (m_timer != -1)
+    if (m_timer != -1) {
         killTimer(m_timer);
+        m_timer = -1;
+    }
     if (m_useBuffer) {
-        if (m_fp != -1)
+        if (m_fp != -1) {
             close(m_fp);
+            m_fp = -1;
+        }
         if (!setValue("buffer/enable", 0)) {
             RTeError(getModuleName(), "Failed to disable buffer");
         }
+    } else {
+        closeRawFiles();
     }
+    RTeIIO::stopModule();
+}
+
+void RTeIIOAccel::pollLoop()
+{
+    if (m_fp == -1)
+        return;
+
+    while (waitForData(m_fp))
+        readBuffer();
 }
 
 void RTeIIOAccel::timerEvent(QTimerEvent *)
 {
-    RTEIIOACCEL_DATA rawData;
+    if (m_useBuffer)
+        readBuffer();
+    else
+        readSysfs();
+}
+
+void RTeIIOAccel::readSysfs()
+{
     RTeSensorAccelData accelData;
+    int value;
+    int last;
 
-    if (!m_useBuffer) {
-        QFile dataFile;
-        for (int i = 0; i < 3; i++) {
-            dataFile.setFileName(m_devicePath + m_dataNames[i]);
-            dataFile.open(QIODevice::ReadOnly);
+    for (int i = 0; i < 3; i++) {
+        if (!readAttribute(m_rawFds[i], value))
+            return;
+        accelData.m_accel.setData(i, (RTEFLOAT)value * m_rawScale);
+    }
+    accelData.m_timestampNs = m_clock.currentNSecs();
+    accelData.m_timestamp = m_clock.toEpochUSecs(accelData.m_timestampNs);
+    addRateSamples(&accelData.m_timestampNs, 1);
 
-            QString value = dataFile.readAll();
-            accelData.m_accel.setData(i, value.toDouble() / 1000.0);
+    //  samples are collected so that a batch is emitted per wakeup interval, as in buffer mode
 
-            dataFile.close();
+    if (receivers(SIGNAL(newAccelSampleBatch(RTeModule *, RTeSensorAccelBatch *))) > 0) {
+        last = m_batch.m_count++;
+        m_batch.m_x[last] = accelData.m_accel.x();
+        m_batch.m_y[last] = accelData.m_accel.y();
+        m_batch.m_z[last] = accelData.m_accel.z();
+        m_batch.m_timestamp[last] = accelData.m_timestamp;
+        m_batch.m_timestampNs[last] = accelData.m_timestampNs;
+        if (m_batch.m_count >= m_sysfsBlock) {
+            emit newAccelSampleBatch(this, &m_batch);
+            m_batch.m_count = 0;
         }
-        m_count++;
+    }
+    if (m_broadcast != NULL)
+        m_broadcast->publish(accelData);
+    emit newAccelSample(this, &accelData);
+    m_count++;
+
+    if ((accelData.m_timestamp - m_startTime) >= 1000000) {
+        RTeDebug(getModuleName(), accelData.m_accel.display("Accel"));
+        RTeDebug(getModuleName(), QString("Accel sample rate: %1").arg(m_count));
+        m_count = 0;
+        m_startTime = accelData.m_timestamp;
+        m_clock.updateOffset();
+    }
+}
+
+void RTeIIOAccel::readBuffer()
+{
+    int space;
+    int count;
+
+    if ((m_fp == -1) || (m_decoder.scanSize() <= 0))
+        return;
+
+    while (1) {
+        space = RTEIIO_STAGING_SIZE - m_stagingBytes;
+
+        if ((count = readStaging(m_fp)) <= 0)
+            return;
+
+        processStaging(m_decoder.hasTimestamp() && !m_measureLatency ? 0 : m_clock.currentNSecs());
+
+        //  formatted on the stack so that the debug build doesn't allocate on the read thread
 
         if ((RTeMath::currentUSecsSinceEpoch() - m_startTime) >= 1000000) {
-            qDebug() << accelData.m_accel.display("Accel: ");
-            qDebug() << "Sample rate: " << m_count;
+            if (RTELOG_ENABLED(RTELOG_DEBUG)) {
+                char text[RTELOG_TEXT_SIZE];
+
+                snprintf(text, sizeof(text), "Accel sample rate: %d (measured %.3f, drift %.0fppm), lost %lld",
+                         m_count, getMeasuredRate(), getDriftPPM(), (long long)getSampleStats().m_lostSamples);
+                RTeLog::addMessage(getModuleName(), RTELOG_DEBUG, text);
+            }
             m_count = 0;
             m_startTime = RTeMath::currentUSecsSinceEpoch();
+            m_clock.updateOffset();
         }
-    } else {
-        while (1) {
-            int count = read(m_fp, (char *)(&rawData) + m_bytesGot, m_bytesLeft);
 
-            if (count <= 0) {
-                if (errno != EAGAIN)
-                    RTeError(getModuleName(), QString("Read failed %1").arg(errno));
-                return;
+        //  a short read means the kernel buffer is empty so skip the read that would return EAGAIN
+
+        if (count < space)
+            return;
+    }
+}
+
+void RTeIIOAccel::processStaging(qint64 now)
+{
+    RTeSensorAccelData accelData;
+    int scanSize = m_decoder.scanSize();
+    int offset = 0;
+    int scans;
+    int block;
+    int i;
+
+    //  without a timestamp channel the samples are spaced at the nominal period
+    //  so that the newest one in the staging buffer lands on now
+
+    qint64 period = m_rateEstimator.nominalRate() > 0 ? (qint64)(1000000000.0 / m_rateEstimator.nominalRate()) : 0;
+    qint64 backfill = now - (qint64)(m_stagingBytes / scanSize - 1) * period;
+
+    //  only do the per sample work if someone is listening
+
+    bool wantSamples = receivers(SIGNAL(newAccelSample(RTeModule *, RTeSensorAccelData *))) > 0;
+    bool wantBatches = receivers(SIGNAL(newAccelSampleBatch(RTeModule *, RTeSensorAccelBatch *))) > 0;
+
+    for (scans = m_stagingBytes / scanSize; scans > 0; scans -= block) {
+        block = scans < RTEIIO_DECODE_BLOCK ? scans : RTEIIO_DECODE_BLOCK;
+        m_decoder.decode(m_staging + offset, block, m_batch.m_x, m_batch.m_y, m_batch.m_z, m_batch.m_timestampNs);
+        m_batch.m_count = block;
+        offset += block * scanSize;
+
+        if (!m_decoder.hasTimestamp()) {
+            for (i = 0; i < block; i++, backfill += period)
+                m_batch.m_timestampNs[i] = backfill;
+        } else if (m_measureLatency) {
+            for (i = 0; i < block; i++)
+                m_kernelLatency.record(now - m_batch.m_timestampNs[i]);
+        }
+
+        //  the nS timestamps are kept as they are, the uS ones are mapped to the epoch
+
+        for (i = 0; i < block; i++)
+            m_batch.m_timestamp[i] = m_clock.toEpochUSecs(m_batch.m_timestampNs[i]);
+
+        //  back-filled timestamps say nothing about the real rate so only measure real ones
+
+        if (m_decoder.hasTimestamp()) {
+            addRateSamples(m_batch.m_timestampNs, block);
+            if (checkTimestamps(m_batch.m_timestampNs, block)) {
+                RTEIIO_SAMPLE_STATS stats = getSampleStats();
+                emit sampleLoss(this, &stats);
             }
+        }
 
-            m_bytesGot += count;
-            m_bytesLeft -=count;
-
-            if (m_bytesLeft <= 0) {
-                m_count++;
-                m_bytesGot = 0;
-                m_bytesLeft = sizeof(RTEIIOACCEL_DATA);
-                accelData.m_accel.setX((RTEFLOAT)rawData.x / (RTEFLOAT)16384.0);
-                accelData.m_accel.setY((RTEFLOAT)rawData.y / (RTEFLOAT)16384.0);
-                accelData.m_accel.setZ((RTEFLOAT)rawData.z / (RTEFLOAT)16384.0);
-                accelData.m_timestamp = rawData.timestamp / 1000;
-                emit newAccelSample(this, &accelData);
-
-                if ((RTeMath::currentUSecsSinceEpoch() - m_startTime) >= 1000000) {
-                    RTeDebug(getModuleName(), QString("Accel sample rate: %1").arg(m_count));
-                    m_count = 0;
-                    m_startTime = RTeMath::currentUSecsSinceEpoch();
-                }
+        if (wantBatches)
+            emit newAccelSampleBatch(this, &m_batch);
+
+        //  read() to emit covers the decode and the batch delivery of every block so far
+
+        if (m_measureLatency)
+            m_readLatency.record(RTeClock::currentNSecs(CLOCK_MONOTONIC) - m_readTime);
+
+        if (wantSamples || (m_broadcast != NULL)) {
+            for (i = 0; i < block; i++) {
+                accelData.m_accel.setX(m_batch.m_x[i]);
+                accelData.m_accel.setY(m_batch.m_y[i]);
+                accelData.m_accel.setZ(m_batch.m_z[i]);
+                accelData.m_timestamp = m_batch.m_timestamp[i];
+                accelData.m_timestampNs = m_batch.m_timestampNs[i];
+                if (m_broadcast != NULL)
+                    m_broadcast->publish(accelData);
+                if (wantSamples)
+                    emit newAccelSample(this, &accelData);
             }
         }
+        m_count += block;
     }
+    consumeStaging(offset);
 }
-
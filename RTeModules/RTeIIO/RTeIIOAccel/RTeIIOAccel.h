@@ -25,20 +25,19 @@
 #define	_RTEIIOACCEL_H
 
 #include "RTeIIO.h"
+#include "RTeIIOScan.h"
+#include "RTeBroadcastRing.h"
 
 #define RTEMBEDDED_EXTRADIRECTORIES_IIOACCEL \
     ..:RTeIIO;
 
 #define RTEMBEDDED_SIGNALS_IIOACCEL \
-    void newAccelSample(RTeModule *, RTeSensorAccelData *);
+    void newAccelSample(RTeModule *, RTeSensorAccelData *); \
+    void newAccelSampleBatch(RTeModule *, RTeSensorAccelBatch *); \
+    void sampleLoss(RTeModule *, RTEIIO_SAMPLE_STATS *);
 
-typedef struct
-{
-    qint16 x;
-    qint16 y;
-    qint16 z;
-    qint64 timestamp;
-} RTEIIOACCEL_DATA;
+#define RTEIIOACCEL_GRAVITY             9.80665             // IIO accel scale is in m/s^2, samples are in g
+#define RTEIIOACCEL_RATE_MAX            8                   // setSampleRate() index for the highest rate
 
 class RTeIIOAccel : public RTeIIO
 {
@@ -46,30 +45,88 @@ class RTeIIOAccel : public RTeIIO
 
 public:
     RTeIIOAccel();
+    virtual ~RTeIIOAccel();
+
+    //  setSampleRate() takes an index into 1, 10, 25, 50, 100, 200, 400 and 1600Hz,
+    //  or 8 for the highest rate. The nearest rate the device supports is used.
 
     void setSampleRate(const QString& rate) { m_sampleRate = rate.toInt(); }
+
+    //  setFSR() sets the full scale range needed in g. The smallest range the device
+    //  supports that covers it is used. 0 (the default) leaves the range unchanged.
+
     void setFSR(const QString& fsr) { m_fsr = fsr.toInt(); }
 
+    //  setBroadcastSize() creates a broadcast ring holding the last size samples.
+    //  Any number of consumers can then read every sample at their own pace
+    //  through an RTeBroadcastReader on getBroadcast() without extra work in
+    //  the acquisition thread. It must be called before the thread is started.
+
+    void setBroadcastSize(const QString& size);
+    const RTeBroadcastRing<RTeSensorAccelData> *getBroadcast() const { return m_broadcast; }
+
 signals:
     void newAccelSample(RTeModule *, RTeSensorAccelData *);
 
+    //  newAccelSampleBatch is emitted once per buffer drain, or once per
+    //  RTEIIO_DECODE_BLOCK scans if more than that had built up since the
+    //  last drain (the batch arrays are a fixed size). The watermark is kept
+    //  below RTEIIO_DECODE_BLOCK so this only happens if the thread falls behind.
+
+    void newAccelSampleBatch(RTeModule *, RTeSensorAccelBatch *);
+
+    //  sampleLoss is emitted with the updated counters when a block of samples
+    //  contains gaps, duplicates or reversed timestamps
+
+    void sampleLoss(RTeModule *, RTEIIO_SAMPLE_STATS *);
+
+protected slots:
+    void pollLoop();                                        // blocks on the buffer until stopped
+
 protected:
     void initModule();
     void stopModule();
     void timerEvent(QTimerEvent *);
 
+    //  setupDecoder() prepares the decoder for m_layout. scale is the kernel's
+    //  in_accel_scale (m/s^2 per unit) or 0 if not known.
+
+    bool setupDecoder(qreal scale);
+
+    //  processStaging() decodes and emits all the complete scans in m_staging.
+    //  now is the time of the read on the timestamp clock. It is used as the
+    //  timestamp if the layout has no timestamp channel. The read latency is
+    //  measured from m_readTime to the end of each block's batch emit.
+
+    void processStaging(qint64 now);
+
+    RTeIIOScanLayout m_layout;                              // layout of the enabled scan elements
+    RTeIIOTripletDecoder m_decoder;                         // converts scans to samples
+    RTeSensorAccelBatch m_batch;                            // the batch being decoded
+    RTeBroadcastRing<RTeSensorAccelData> *m_broadcast;     // NULL unless setBroadcastSize() was called
+
+    qint64 m_startTime;
+    int m_count;
+
 private:
+    void readSysfs();
+    void readBuffer();
+    bool setupDecoder();
+    qreal requestedRate();
+    void addScale(RTeIIOSettings& settings);
+    bool openRawFiles();
+    void closeRawFiles();
+
     int m_sampleRate;                                       // the accel sample rate
     int m_fsr;                                              // the accel full scale range
 
     QString m_dataNames[3];
-
-    qint64 m_startTime;
-    int m_count;
+    int m_rawFds[3];                                        // open in_accel_*_raw files for sysfs polling
+    RTEFLOAT m_rawScale;                                    // converts raw sysfs values to g
+    qreal m_rate;                                           // sample rate in Hz
+    int m_sysfsBlock;                                       // samples per batch when polling sysfs
 
     int m_fp;
-    int m_bytesGot;
-    int m_bytesLeft;
 };
 
 #endif // _RTEIIOACCEL_H
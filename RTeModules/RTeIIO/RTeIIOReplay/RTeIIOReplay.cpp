@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RTeIIOReplay.h"
+
+RTeIIOReplay::RTeIIOReplay() : RTeIIOAccel()
+{
+    m_paced = true;
+}
+
+void RTeIIOReplay::initModule()
+{
+    QString value;
+    qreal scale = 0;
+    qreal rate = 0;
+
+    //  replayLoop() runs to the end of the file so it can't share a pool thread
+
+    if (m_useExecutor) {
+        RTeError(getModuleName(), "Replay blocks until the end of the file and can't run on the executor");
+        return;
+    }
+
+    if (!m_reader.open(m_replayFile))
+        return;
+
+    //  timestamps are mapped to the epoch exactly as they were when recorded
+
+    if (!m_clock.setClock(m_reader.clockName()))
+        m_clock.setClock("realtime");
+    m_clock.setOffset(m_reader.epochOffset());
+
+    if (m_reader.attribute("in_accel_scale", value) || m_reader.attribute("in_accel_x_scale", value))
+        scale = value.toDouble();
+    if (m_reader.attribute("sampling_frequency", value))
+        rate = value.toDouble();
+
+    m_layout = m_reader.layout();
+    if (!setupDecoder(scale))
+        return;
+    setExpectedRate(rate);
+
+    m_stagingBytes = 0;
+    m_count = 0;
+    QMetaObject::invokeMethod(this, "replayLoop", Qt::QueuedConnection);
+}
+
+//  there's no device so RTeIIOAccel::stopModule() is skipped
+
+void RTeIIOReplay::stopModule()
+{
+    m_reader.close();
+    RTeIIO::stopModule();
+}
+
+void RTeIIOReplay::replayLoop()
+{
+    qint64 start = RTeClock::currentNSecs(CLOCK_MONOTONIC);
+    qint64 firstCapture = 0;
+    qint64 captureTime;
+    qint64 delay;
+    qint64 records = 0;
+    int length;
+
+    while (1) {
+        length = m_reader.readRecord(captureTime, m_staging + m_stagingBytes, RTEIIO_STAGING_SIZE - m_stagingBytes);
+
+        if (length < 0) {
+            RTeError(getModuleName(), QString("Bad record in ") + m_replayFile);
+            break;
+        }
+        if (length == 0)
+            break;
+
+        if (records == 0)
+            firstCapture = captureTime;
+
+        if (m_paced) {
+            delay = (captureTime - firstCapture) - (RTeClock::currentNSecs(CLOCK_MONOTONIC) - start);
+            if (waitForStop(delay > 0 ? (int)((delay + 999999) / 1000000) : 0))
+                return;
+        } else if (((records % RTEIIOREPLAY_STOP_CHECK) == 0) && waitForStop(0)) {
+            return;
+        }
+
+        m_stagingBytes += length;
+        if (m_measureLatency)
+            m_readTime = RTeClock::currentNSecs(CLOCK_MONOTONIC);
+        processStaging(captureTime);
+        records++;
+    }
+
+    qint64 elapsed = RTeClock::currentNSecs(CLOCK_MONOTONIC) - start;
+
+    RTeInfo(getModuleName(), QString("Replayed %1 samples in %2mS (%3 samples per second)")
+            .arg(m_count).arg(elapsed / 1000000)
+            .arg(elapsed > 0 ? (qreal)m_count * 1000000000.0 / (qreal)elapsed : 0, 0, 'f', 0));
+    emit replayComplete(this);
+}
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTEIIOREPLAY_H
+#define	_RTEIIOREPLAY_H
+
+#include "RTeIIOAccel.h"
+#include "RTeIIOCapture.h"
+
+#define RTEMBEDDED_EXTRADIRECTORIES_IIOREPLAY \
+    ..:RTeIIOAccel; \
+    ..:RTeIIO;
+
+#define RTEMBEDDED_SIGNALS_IIOREPLAY \
+    RTEMBEDDED_SIGNALS_IIOACCEL \
+    void replayComplete(RTeModule *);
+
+#define RTEIIOREPLAY_STOP_CHECK         256                 // records between stop checks in fast mode
+
+//  RTeIIOReplay plays back a file recorded with RTeIIO::setCaptureFile(). The
+//  recorded scans go through the same decoder as RTeIIOAccel so the same
+//  newAccelSample and newAccelSampleBatch signals are emitted. In "paced" mode
+//  reads are spaced as they were recorded, in "fast" mode they are replayed
+//  as fast as the connected modules can take them.
+
+class RTeIIOReplay : public RTeIIOAccel
+{
+    Q_OBJECT
+
+public:
+    RTeIIOReplay();
+
+    void setReplayFile(const QString& path) { m_replayFile = path; }
+    void setReplayMode(const QString& mode) { m_paced = mode != "fast"; }
+
+signals:
+    //  replayComplete is emitted when the end of the file is reached
+
+    void replayComplete(RTeModule *);
+
+protected slots:
+    void replayLoop();
+
+protected:
+    void initModule();
+    void stopModule();
+
+private:
+    QString m_replayFile;
+    bool m_paced;                                           // true to keep the recorded timing
+    RTeIIOCaptureReader m_reader;
+};
+
+#endif // _RTEIIOREPLAY_H
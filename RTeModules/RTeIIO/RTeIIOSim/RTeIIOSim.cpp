@@ -0,0 +1,409 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RTeIIOSim.h"
+#include "RTeLog.h"
+#include "RTeMath.h"
+
+#include <qdir.h>
+#include <qfile.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/stat.h>
+
+static const char *simAxisNames[3] = {"in_accel_x", "in_accel_y", "in_accel_z"};
+
+RTeIIOSim::RTeIIOSim() : RTeThreadedModule()
+{
+    m_deviceRoot = "/tmp/iiosim/";
+    m_deviceNumber = 0;
+    setDeviceNumber("0");
+    m_axisType = "le:s12/16>>4";
+    m_scale = 0.009806650;
+    m_noise = 0.01;
+    m_jitter = 0;
+    m_gapRate = 0;
+    m_partialWrites = false;
+    m_random = 0x2545F4914F6CDD1DULL;
+    m_timer = -1;
+    m_fifo = -1;
+    m_enableFd = -1;
+    for (int i = 0; i < 3; i++)
+        m_rawFds[i] = -1;
+    m_enabled = false;
+    m_period = 0;
+    m_nextSample = 0;
+    m_scansWritten = 0;
+    m_scansDropped = 0;
+}
+
+void RTeIIOSim::setDeviceRoot(const QString& root)
+{
+    m_deviceRoot = root;
+    if (!m_deviceRoot.endsWith("/"))
+        m_deviceRoot += "/";
+    setDeviceNumber(QString::number(m_deviceNumber));
+}
+
+void RTeIIOSim::setDeviceNumber(const QString& number)
+{
+    m_deviceNumber = number.toInt();
+    m_devicePath = m_deviceRoot + QString("sys/bus/iio/devices/iio:device%1/").arg(m_deviceNumber);
+    m_deviceBuffer = m_deviceRoot + QString("dev/iio:device%1").arg(m_deviceNumber);
+}
+
+void RTeIIOSim::resumeThread()
+{
+    createDevice();
+    RTeThreadedModule::resumeThread();
+}
+
+bool RTeIIOSim::createDevice()
+{
+    QDir dir;
+    int i;
+
+    if (!dir.mkpath(m_devicePath + "buffer") || !dir.mkpath(m_devicePath + "scan_elements") ||
+            !dir.mkpath(m_deviceRoot + "dev")) {
+        RTeError(getModuleName(), QString("Failed to create ") + m_devicePath);
+        return false;
+    }
+
+    m_layout.clear();
+    for (i = 0; i < 3; i++) {
+        if (!m_layout.addChannel(simAxisNames[i], i, m_axisType)) {
+            RTeError(getModuleName(), QString("Invalid axis type ") + m_axisType);
+            return false;
+        }
+        writeFile(QString("scan_elements/%1_en").arg(simAxisNames[i]), "1");
+        writeFile(QString("scan_elements/%1_index").arg(simAxisNames[i]), QString::number(i));
+        writeFile(QString("scan_elements/%1_type").arg(simAxisNames[i]), m_axisType);
+        writeFile(QString("%1_raw").arg(simAxisNames[i]), "0");
+    }
+    m_layout.addChannel("in_timestamp", 3, "le:s64/64>>0");
+    writeFile("scan_elements/in_timestamp_en", "1");
+    writeFile("scan_elements/in_timestamp_index", "3");
+    writeFile("scan_elements/in_timestamp_type", "le:s64/64>>0");
+
+    writeFile("name", "iio_sim_accel");
+    writeFile("sampling_frequency", "25");
+    writeFile("sampling_frequency_available", "1 10 25 50 100 200 400 1600 3200 6400 12800 25600 51200 102400");
+    writeFile("in_accel_scale", QString::number(m_scale, 'f', 9));
+    writeFile("in_accel_scale_available", QString("%1 %2 %3 %4").arg(m_scale, 0, 'f', 9)
+              .arg(m_scale * 2, 0, 'f', 9).arg(m_scale * 4, 0, 'f', 9).arg(m_scale * 12, 0, 'f', 9));
+    writeFile("current_timestamp_clock", "monotonic_raw");
+    writeFile("buffer/enable", "0");
+    writeFile("buffer/length", "128");
+    writeFile("buffer/watermark", "1");
+
+    //  the fifo is opened read/write so that the open doesn't wait for a reader
+    //  and the fifo stays valid while readers come and go
+
+    QByteArray fifoPath = m_deviceBuffer.toLocal8Bit();
+
+    unlink(fifoPath.constData());
+    if (mkfifo(fifoPath.constData(), 0666) < 0) {
+        RTeError(getModuleName(), QString("Failed to create fifo ") + m_deviceBuffer);
+        return false;
+    }
+    if ((m_fifo = open(fifoPath.constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC)) == -1) {
+        RTeError(getModuleName(), QString("Failed to open fifo ") + m_deviceBuffer);
+        return false;
+    }
+#ifdef F_SETPIPE_SZ
+    fcntl(m_fifo, F_SETPIPE_SZ, RTEIIOSIM_PIPE_SIZE);
+#endif
+
+    m_enableFd = open(qPrintable(m_devicePath + "buffer/enable"), O_RDONLY | O_CLOEXEC);
+    for (i = 0; i < 3; i++)
+        m_rawFds[i] = open(qPrintable(m_devicePath + simAxisNames[i] + "_raw"), O_WRONLY | O_CLOEXEC);
+
+    m_scans.resize(RTEIIOSIM_MAX_SCANS * m_layout.scanSize());
+    m_pending.clear();
+    return true;
+}
+
+void RTeIIOSim::initModule()
+{
+    m_clock.setClock("monotonic_raw");
+    m_timer = startTimer(RTEIIOSIM_TICK);
+}
+
+void RTeIIOSim::stopModule()
+{
+    if (m_timer != -1) {
+        killTimer(m_timer);
+        m_timer = -1;
+    }
+    if (m_fifo != -1) {
+        close(m_fifo);
+        m_fifo = -1;
+    }
+    if (m_enableFd != -1) {
+        close(m_enableFd);
+        m_enableFd = -1;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (m_rawFds[i] != -1) {
+            close(m_rawFds[i]);
+            m_rawFds[i] = -1;
+        }
+    }
+    RTeInfo(getModuleName(), QString("Wrote %1 scans, dropped %2").arg(m_scansWritten).arg(m_scansDropped));
+}
+
+void RTeIIOSim::timerEvent(QTimerEvent *)
+{
+    bool enabled = bufferEnabled();
+
+    if (enabled && !m_enabled)
+        startBuffer();
+    m_enabled = enabled;
+
+    if (m_enabled)
+        generateScans(m_clock.currentNSecs());
+    else
+        updateRaw();
+}
+
+bool RTeIIOSim::bufferEnabled()
+{
+    char value;
+
+    if (m_enableFd == -1)
+        return false;
+    return (pread(m_enableFd, &value, 1, 0) == 1) && (value == '1');
+}
+
+//  startBuffer() picks up the configuration written by the reader
+
+void RTeIIOSim::startBuffer()
+{
+    QString value;
+    qreal rate = 25;
+
+    if (readFile("sampling_frequency", value) && (value.toDouble() > 0))
+        rate = value.toDouble();
+    if (readFile("in_accel_scale", value) && (value.toDouble() > 0))
+        m_scale = value.toDouble();
+    if (readFile("current_timestamp_clock", value) && !m_clock.setClock(value))
+        m_clock.setClock("monotonic_raw");
+
+    m_period = (qint64)(1000000000.0 / rate);
+    m_nextSample = m_clock.currentNSecs();
+    m_pending.clear();
+    RTeDebug(getModuleName(), QString("Buffer started at %1Hz").arg(rate));
+}
+
+//  generateScans() writes every sample due up to now
+
+void RTeIIOSim::generateScans(qint64 now)
+{
+    const RTEIIO_CHANNEL& timestampChannel = m_layout.channel(3);
+    int scanSize = m_layout.scanSize();
+    unsigned char *scan = (unsigned char *)m_scans.data();
+    int count = 0;
+    qint64 raw[3];
+    qint64 timestamp;
+
+    while ((m_nextSample <= now) && (count < RTEIIOSIM_MAX_SCANS)) {
+        timestamp = m_nextSample;
+        m_nextSample += m_period;
+
+        if ((m_gapRate > 0) && (uniform() < m_gapRate)) {
+            m_scansDropped++;
+            continue;
+        }
+
+        if (m_jitter > 0)
+            timestamp += (qint64)((uniform() * 2.0 - 1.0) * m_jitter * 1000.0);
+
+        memset(scan, 0, scanSize);
+        makeSample(raw);
+        for (int i = 0; i < 3; i++)
+            RTeIIOScanLayout::encodeChannel(scan, m_layout.channel(i), raw[i]);
+        RTeIIOScanLayout::encodeChannel(scan, timestampChannel, timestamp);
+
+        scan += scanSize;
+        count++;
+    }
+
+    //  if the reader is so far behind that there was no room, skip forward
+
+    if (m_nextSample <= now) {
+        m_scansDropped += (now - m_nextSample) / m_period + 1;
+        m_nextSample += ((now - m_nextSample) / m_period + 1) * m_period;
+    }
+
+    writeFifo(count * scanSize);
+}
+
+//  writeFifo() writes length bytes from m_scans after any pending partial scan.
+//  Data that doesn't fit is dropped on a scan boundary like a kernel overrun.
+
+void RTeIIOSim::writeFifo(int length)
+{
+    int scanSize = m_layout.scanSize();
+    int written;
+    int hold = 0;
+
+    if (m_pending.size() > 0) {
+        written = write(m_fifo, m_pending.constData(), m_pending.size());
+        if (written < 0)
+            written = 0;
+        m_pending = m_pending.mid(written);
+        if (m_pending.size() > 0) {
+            m_scansDropped += length / scanSize;
+            return;
+        }
+    }
+
+    if (length == 0)
+        return;
+
+    //  hold back the end of the last scan to the next tick to simulate a partial read
+
+    if (m_partialWrites)
+        hold = 1 + (int)(uniform() * (scanSize - 1));
+
+    written = write(m_fifo, m_scans.constData(), length - hold);
+    if (written < 0)
+        written = 0;
+
+    if (written < length - hold) {
+        //  complete the scan that was cut off, drop the rest
+
+        int complete = ((written + scanSize - 1) / scanSize) * scanSize;
+
+        m_pending = QByteArray(m_scans.constData() + written, complete - written);
+        m_scansDropped += (length - complete) / scanSize;
+        m_scansWritten += complete / scanSize;
+    } else {
+        m_pending = QByteArray(m_scans.constData() + written, hold);
+        m_scansWritten += length / scanSize;
+    }
+}
+
+//  updateRaw() refreshes the in_accel_*_raw files for sysfs polling
+
+void RTeIIOSim::updateRaw()
+{
+    qint64 raw[3];
+    QByteArray value;
+
+    makeSample(raw);
+    for (int i = 0; i < 3; i++) {
+        if (m_rawFds[i] == -1)
+            continue;
+        value = QByteArray::number(raw[i]);
+        if ((pwrite(m_rawFds[i], value.constData(), value.length(), 0) != value.length()) ||
+                (ftruncate(m_rawFds[i], value.length()) < 0))
+            RTeErrorLimited(getModuleName(), QString("Failed to write raw value %1").arg(errno));
+    }
+}
+
+//  makeSample() generates a level device (1g on z) plus noise in raw units
+
+void RTeIIOSim::makeSample(qint64 *raw)
+{
+    qreal perLsb = m_scale / 9.80665;
+    qreal value;
+
+    for (int i = 0; i < 3; i++) {
+        const RTEIIO_CHANNEL& axis = m_layout.channel(i);
+        qint64 maxRaw = axis.m_signed ? ((qint64)1 << (axis.m_bits - 1)) - 1 : ((qint64)1 << axis.m_bits) - 1;
+        qint64 minRaw = axis.m_signed ? -maxRaw - 1 : 0;
+
+        value = (i == 2 ? 1.0 : 0.0) + m_noise * gaussian();
+        raw[i] = (qint64)floor(value / perLsb + 0.5);
+        if (raw[i] > maxRaw)
+            raw[i] = maxRaw;
+        if (raw[i] < minRaw)
+            raw[i] = minRaw;
+    }
+}
+
+bool RTeIIOSim::writeFile(const QString& file, const QString& value)
+{
+    QFile deviceFile(m_devicePath + file);
+
+    if (!deviceFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    if (deviceFile.write(qPrintable(value + "\n")) < 0) {
+        deviceFile.close();
+        return false;
+    }
+    deviceFile.close();
+    return true;
+}
+
+//  readFile() returns the first line of an attribute. Readers write attributes
+//  in place as sysfs replaces the whole value, so with an ordinary file the end
+//  of a longer old value is left after the newline. It is removed here.
+
+bool RTeIIOSim::readFile(const QString& file, QString& value)
+{
+    QFile deviceFile(m_devicePath + file);
+    QByteArray contents;
+    int end;
+
+    if (!deviceFile.open(QIODevice::ReadWrite))
+        return false;
+    contents = deviceFile.readAll();
+    if ((end = contents.indexOf('\n')) >= 0) {
+        if (end + 1 < contents.size())
+            deviceFile.resize(end + 1);
+        contents.truncate(end);
+    }
+    deviceFile.close();
+    value = QString(contents).trimmed();
+    return true;
+}
+
+//  xorshift64* - fast and repeatable for a given seed
+
+quint64 RTeIIOSim::random()
+{
+    m_random ^= m_random >> 12;
+    m_random ^= m_random << 25;
+    m_random ^= m_random >> 27;
+    return m_random * 2685821657736338717ULL;
+}
+
+qreal RTeIIOSim::uniform()
+{
+    return (qreal)(random() >> 11) / 9007199254740992.0;
+}
+
+qreal RTeIIOSim::gaussian()
+{
+    qreal u1 = uniform();
+    qreal u2 = uniform();
+
+    if (u1 < 1e-300)
+        u1 = 1e-300;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * RTEMATH_PI * u2);
+}
@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RTEIIOSIM_H
+#define	_RTEIIOSIM_H
+
+#include "RTeThreadedModule.h"
+#include "RTeIIOScan.h"
+#include "RTeClock.h"
+
+#include <qbytearray.h>
+
+#define RTEMBEDDED_EXTRADIRECTORIES_IIOSIM \
+    ..:RTeIIO;
+
+#define RTEIIOSIM_TICK                  1                   // mS between generation ticks
+#define RTEIIOSIM_MAX_SCANS             4096                // max scans generated per tick
+#define RTEIIOSIM_PIPE_SIZE             (1024 * 1024)       // requested size of the buffer fifo
+
+//  RTeIIOSim is a stand-in for an IIO accelerometer. It builds a fake sysfs
+//  tree and /dev/iio:deviceN fifo under a device root directory and, while
+//  buffer/enable is 1, writes scans to the fifo at the rate set in
+//  sampling_frequency. With the buffer disabled it updates in_accel_*_raw.
+//  Noise, timestamp jitter, lost samples and partial writes can be injected.
+//
+//  Point RTeIIO::setDeviceRoot() at the same directory to use it.
+
+class RTeIIOSim : public RTeThreadedModule
+{
+    Q_OBJECT
+
+public:
+    RTeIIOSim();
+
+    //  resumeThread() creates the device before starting the thread so that
+    //  it exists before any reader is initialized
+
+    virtual void resumeThread();
+
+    void setDeviceRoot(const QString& root);
+    void setDeviceNumber(const QString& number);
+    void setAxisType(const QString& type) { m_axisType = type; }
+    void setScale(const QString& scale) { m_scale = scale.toDouble(); }
+    void setNoise(const QString& noise) { m_noise = noise.toDouble(); }
+    void setJitter(const QString& jitter) { m_jitter = jitter.toInt(); }
+    void setGapRate(const QString& gapRate) { m_gapRate = gapRate.toDouble(); }
+    void setPartialWrites(const QString& partial) { m_partialWrites = partial == "true"; }
+    void setSeed(const QString& seed) { if (!seed.isEmpty()) m_random = seed.toULongLong() | 1; }
+
+    //  createDevice() builds the sysfs tree and buffer fifo
+
+    bool createDevice();
+
+    qint64 getScansWritten() const { return m_scansWritten; }
+    qint64 getScansDropped() const { return m_scansDropped; }
+
+protected:
+    void initModule();
+    void stopModule();
+    void timerEvent(QTimerEvent *);
+
+private:
+    bool writeFile(const QString& file, const QString& value);
+    bool readFile(const QString& file, QString& value);
+    bool bufferEnabled();
+    void startBuffer();
+    void generateScans(qint64 now);
+    void updateRaw();
+    void makeSample(qint64 *raw);
+    void writeFifo(int length);
+
+    quint64 random();
+    qreal uniform();                                        // 0 to 1
+    qreal gaussian();                                       // mean 0, sd 1
+
+    QString m_deviceRoot;
+    int m_deviceNumber;
+    QString m_devicePath;
+    QString m_deviceBuffer;
+
+    QString m_axisType;                                     // scan type used for the axes
+    qreal m_scale;                                          // m/s^2 per lsb
+    qreal m_noise;                                          // RMS noise in g
+    int m_jitter;                                           // max timestamp jitter in uS
+    qreal m_gapRate;                                        // probability that a sample is lost
+    bool m_partialWrites;                                   // true to split writes in the middle of scans
+    quint64 m_random;                                       // xorshift state
+
+    RTeIIOScanLayout m_layout;
+    RTeClock m_clock;
+
+    int m_timer;
+    int m_fifo;
+    int m_enableFd;
+    int m_rawFds[3];
+
+    bool m_enabled;
+    qint64 m_period;                                        // nS between samples
+    qint64 m_nextSample;                                    // nS time of the next sample
+
+    QByteArray m_scans;                                     // scans generated in one tick
+    QByteArray m_pending;                                   // part of a scan still to be written
+    qint64 m_scansWritten;
+    qint64 m_scansDropped;
+};
+
+#endif // _RTEIIOSIM_H
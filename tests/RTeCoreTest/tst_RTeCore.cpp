@@ -0,0 +1,539 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//  Checks for the lock free queues, the raw sample conversion kernels and the
+//  batch math. The SIMD code is compared against the scalar reference code.
+
+#include <QtTest/QtTest>
+
+#include "RTeSPSCQueue.h"
+#include "RTeTripleBuffer.h"
+#include "RTeBroadcastRing.h"
+#include "RTeConvert.h"
+#include "RTeMathBatch.h"
+
+#include <qthread.h>
+#include <qelapsedtimer.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define TST_QUEUE_ITEMS                 1000000             // items passed between threads
+#define TST_LATEST_ITEMS                10000               // items put through the triple buffer
+#define TST_LATEST_WORDS                512                 // words in each triple buffer item
+#define TST_BATCH_TOLERANCE             4e-7                // SIMD vs scalar batch math difference
+#define TST_ANGLE_TOLERANCE             1e-5                // angle/vector round trip difference
+#define TST_BENCH_SCANS                 4096                // scans converted per benchmark pass
+#define TST_BENCH_ELEMENTS              100000              // elements per batch math benchmark pass
+
+#if QT_VERSION >= 0x050000
+#define TST_SKIP(message) QSKIP(message)
+#else
+#define TST_SKIP(message) QSKIP(message, SkipSingle)
+#endif
+
+static RTEFLOAT randomFloat()
+{
+    return (rand() / (RTEFLOAT)RAND_MAX) * 2 - 1;
+}
+
+//  TstProducer pushes increasing integers from its own thread
+
+class TstProducer : public QThread
+{
+public:
+    TstProducer(RTeSPSCQueue<int> *queue) { m_queue = queue; }
+
+protected:
+    void run()
+    {
+        for (int i = 0; i < TST_QUEUE_ITEMS; i++) {
+            while (!m_queue->push(i))
+                ;
+        }
+    }
+
+private:
+    RTeSPSCQueue<int> *m_queue;
+};
+
+//  TstLatestItem is too large for RTeMailbox. TstLatestWriter fills every
+//  word of each item with the same increasing value.
+
+typedef struct
+{
+    int m_words[TST_LATEST_WORDS];
+} TstLatestItem;
+
+class TstLatestWriter : public QThread
+{
+public:
+    TstLatestWriter(RTeTripleBuffer<TstLatestItem> *buffer) { m_buffer = buffer; }
+
+protected:
+    void run()
+    {
+        TstLatestItem *item;
+
+        for (int i = 1; i <= TST_LATEST_ITEMS; i++) {
+            item = m_buffer->beginPut();
+            for (int w = 0; w < TST_LATEST_WORDS; w++)
+                item->m_words[w] = i;
+            m_buffer->endPut();
+        }
+    }
+
+private:
+    RTeTripleBuffer<TstLatestItem> *m_buffer;
+};
+
+class tst_RTeCore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void queueDropNewest();
+    void queueDropOldest();
+    void queueCoalesce();
+    void queueTakeLast();
+    void queuePushSlot();
+    void queueBlockWithTimeout();
+    void queueMemoryLimit();
+    void queueThreaded();
+
+    void tripleBuffer();
+
+    void broadcastRead();
+    void broadcastOverrun();
+
+    void convert_data();
+    void convert();
+    void convertBenchmark_data();
+    void convertBenchmark();
+
+    void mathBatch();
+    void mathAngleVector();
+    void mathBatchBenchmark_data();
+    void mathBatchBenchmark();
+
+private:
+    void fillQueue(RTeSPSCQueue<int>& queue, int count);
+
+    unsigned char m_raw[16 * 64 + 16];
+};
+
+void tst_RTeCore::initTestCase()
+{
+    srand(1);
+    for (unsigned int i = 0; i < sizeof(m_raw); i++)
+        m_raw[i] = rand();
+}
+
+void tst_RTeCore::fillQueue(RTeSPSCQueue<int>& queue, int count)
+{
+    for (int i = 0; i < count; i++)
+        queue.push(i);
+}
+
+void tst_RTeCore::queueDropNewest()
+{
+    RTeSPSCQueue<int> queue(4, RTEQUEUE_DROP_NEWEST);
+    int item;
+
+    fillQueue(queue, 6);
+    QCOMPARE(queue.count(), 4);
+    QCOMPARE(queue.overflows(), (qint64)2);
+    for (int i = 0; i < 4; i++) {
+        QVERIFY(queue.pop(item));
+        QCOMPARE(item, i);
+    }
+    QVERIFY(!queue.pop(item));
+}
+
+void tst_RTeCore::queueDropOldest()
+{
+    RTeSPSCQueue<int> queue(4, RTEQUEUE_DROP_OLDEST);
+    int item;
+
+    fillQueue(queue, 6);
+    QCOMPARE(queue.count(), 4);
+    QCOMPARE(queue.overflows(), (qint64)2);
+    for (int i = 2; i < 6; i++) {
+        QVERIFY(queue.pop(item));
+        QCOMPARE(item, i);
+    }
+    QVERIFY(queue.isEmpty());
+}
+
+void tst_RTeCore::queueCoalesce()
+{
+    RTeSPSCQueue<int> queue(4, RTEQUEUE_COALESCE);
+    int item;
+
+    fillQueue(queue, 10);
+    QCOMPARE(queue.count(), 1);
+    QCOMPARE(queue.overflows(), (qint64)9);
+    QVERIFY(queue.pop(item));
+    QCOMPARE(item, 9);
+}
+
+void tst_RTeCore::queueTakeLast()
+{
+    RTeSPSCQueue<int> queue(8);
+    int item;
+
+    QVERIFY(!queue.takeLast(item));
+    fillQueue(queue, 5);
+    QVERIFY(queue.takeLast(item));
+    QCOMPARE(item, 4);
+    QVERIFY(queue.isEmpty());
+}
+
+//  queuePushSlot() checks that an item filled in place is only seen once committed
+
+void tst_RTeCore::queuePushSlot()
+{
+    RTeSPSCQueue<int> queue(2, RTEQUEUE_DROP_NEWEST);
+    int *slot;
+    int item;
+
+    QVERIFY((slot = queue.pushSlot()) != NULL);
+    *slot = 7;
+    QVERIFY(queue.isEmpty());
+    queue.commitPush();
+    fillQueue(queue, 1);
+    QVERIFY(queue.pushSlot() == NULL);
+    QCOMPARE(queue.overflows(), (qint64)1);
+    QVERIFY(queue.pop(item));
+    QCOMPARE(item, 7);
+}
+
+//  queueBlockWithTimeout() checks that a push to a full queue waits for the
+//  timeout and then drops the item
+
+void tst_RTeCore::queueBlockWithTimeout()
+{
+    RTeSPSCQueue<int> queue(2, RTEQUEUE_BLOCK_WITH_TIMEOUT);
+    QElapsedTimer elapsed;
+
+    queue.setBlockTimeout(2000);
+    fillQueue(queue, 2);
+    elapsed.start();
+    QVERIFY(!queue.push(2));
+    QVERIFY(elapsed.elapsed() >= 2);
+    QCOMPARE(queue.overflows(), (qint64)1);
+}
+
+void tst_RTeCore::queueMemoryLimit()
+{
+    RTeSPSCQueue<int> rounded(100);
+    RTeSPSCQueue<int> limited(1024, RTEQUEUE_DROP_NEWEST, 64 * sizeof(int));
+
+    QCOMPARE(rounded.capacity(), 128);
+    QCOMPARE(limited.capacity(), 64);
+}
+
+//  queueThreaded() checks that every item arrives once and in order
+
+void tst_RTeCore::queueThreaded()
+{
+    RTeSPSCQueue<int> queue(256, RTEQUEUE_DROP_NEWEST);
+    TstProducer producer(&queue);
+    int expected = 0;
+    int item;
+
+    producer.start();
+    while (expected < TST_QUEUE_ITEMS) {
+        if (!queue.pop(item))
+            continue;
+        if (item != expected)
+            break;
+        expected++;
+    }
+    producer.wait();
+    QCOMPARE(expected, TST_QUEUE_ITEMS);
+    QVERIFY(queue.isEmpty());
+}
+
+//  tripleBuffer() checks that the reader never sees a torn or older item
+//  and always gets the last one
+
+void tst_RTeCore::tripleBuffer()
+{
+    RTeTripleBuffer<TstLatestItem> buffer;
+    TstLatestWriter writer(&buffer);
+    TstLatestItem item;
+    int last = 0;
+    int torn = 0;
+    int older = 0;
+
+    QVERIFY(!buffer.getIfNew(item));
+    writer.start();
+    while (last < TST_LATEST_ITEMS) {
+        if (!buffer.getIfNew(item))
+            continue;
+        for (int w = 1; w < TST_LATEST_WORDS; w++) {
+            if (item.m_words[w] != item.m_words[0])
+                torn++;
+        }
+        if (item.m_words[0] <= last)
+            older++;
+        last = item.m_words[0];
+    }
+    writer.wait();
+    QVERIFY(!buffer.getIfNew(item));
+    QCOMPARE(torn, 0);
+    QCOMPARE(older, 0);
+}
+
+void tst_RTeCore::broadcastRead()
+{
+    RTeBroadcastRing<int> ring(16);
+    RTeBroadcastReader<int> first(&ring);
+    int item;
+
+    ring.publish(1);
+    RTeBroadcastReader<int> second(&ring);
+    ring.publish(2);
+    ring.publish(3);
+
+    QCOMPARE(first.lag(), 3);
+    for (int i = 1; i <= 3; i++) {
+        QVERIFY(first.next(item));
+        QCOMPARE(item, i);
+    }
+    QVERIFY(!first.next(item));
+
+    //  a reader only sees what was published after it was created
+
+    QVERIFY(second.next(item));
+    QCOMPARE(item, 2);
+    QCOMPARE(second.overruns(), (qint64)0);
+}
+
+void tst_RTeCore::broadcastOverrun()
+{
+    RTeBroadcastRing<int> ring(16);
+    RTeBroadcastReader<int> reader(&ring);
+    int item;
+
+    for (int i = 0; i < 40; i++)
+        ring.publish(i);
+
+    QCOMPARE(reader.lag(), 16);
+    QVERIFY(reader.next(item));
+    QCOMPARE(item, 24);
+    QCOMPARE(reader.overruns(), (qint64)24);
+}
+
+void tst_RTeCore::convert_data()
+{
+    QTest::addColumn<int>("kernel");
+
+    QTest::newRow("SSE2") << (int)RTECONVERT_SSE2;
+    QTest::newRow("AVX2") << (int)RTECONVERT_AVX2;
+    QTest::newRow("NEON") << (int)RTECONVERT_NEON;
+}
+
+//  convert() checks that each kernel gives exactly the scalar results
+
+void tst_RTeCore::convert()
+{
+    QFETCH(int, kernel);
+    RTEFLOAT rx[64], ry[64], rz[64], rxyz[3 * 64];
+    RTEFLOAT x[64], y[64], z[64], xyz[3 * 64];
+    int strides[] = {6, 8, 16};
+
+    if (!RTeConvert::setKernel((RTECONVERT_KERNEL)kernel)) {
+        RTeConvert::setKernel(RTECONVERT_AUTO);
+        TST_SKIP("Kernel not available on this processor");
+    }
+
+    for (int s = 0; s < 3; s++) {
+        for (int count = 0; count <= 40; count++) {
+            for (int bigEndian = 0; bigEndian < 2; bigEndian++) {
+                for (int shift = 0; shift <= 4; shift += 4) {
+                    memset(rxyz, 0x55, sizeof(rxyz));
+                    memset(xyz, 0x55, sizeof(xyz));
+                    RTeConvert::setKernel(RTECONVERT_SCALAR);
+                    RTeConvert::tripletsToSoA(m_raw + 1, strides[s], count, bigEndian, shift, 0.5, rx, ry, rz);
+                    RTeConvert::tripletsToAoS(m_raw + 1, strides[s], count, bigEndian, shift, 0.5, rxyz);
+                    RTeConvert::setKernel((RTECONVERT_KERNEL)kernel);
+                    RTeConvert::tripletsToSoA(m_raw + 1, strides[s], count, bigEndian, shift, 0.5, x, y, z);
+                    RTeConvert::tripletsToAoS(m_raw + 1, strides[s], count, bigEndian, shift, 0.5, xyz);
+
+                    QVERIFY(memcmp(x, rx, count * sizeof(RTEFLOAT)) == 0);
+                    QVERIFY(memcmp(y, ry, count * sizeof(RTEFLOAT)) == 0);
+                    QVERIFY(memcmp(z, rz, count * sizeof(RTEFLOAT)) == 0);
+                    QVERIFY(memcmp(xyz, rxyz, sizeof(xyz)) == 0);
+                }
+            }
+        }
+    }
+    RTeConvert::setKernel(RTECONVERT_AUTO);
+}
+
+void tst_RTeCore::convertBenchmark_data()
+{
+    QTest::addColumn<int>("kernel");
+
+    QTest::newRow("scalar") << (int)RTECONVERT_SCALAR;
+    QTest::newRow("SSE2") << (int)RTECONVERT_SSE2;
+    QTest::newRow("AVX2") << (int)RTECONVERT_AVX2;
+    QTest::newRow("NEON") << (int)RTECONVERT_NEON;
+}
+
+void tst_RTeCore::convertBenchmark()
+{
+    QFETCH(int, kernel);
+    static unsigned char raw[8 * TST_BENCH_SCANS];
+    static RTEFLOAT x[TST_BENCH_SCANS], y[TST_BENCH_SCANS], z[TST_BENCH_SCANS];
+
+    if (!RTeConvert::setKernel((RTECONVERT_KERNEL)kernel)) {
+        RTeConvert::setKernel(RTECONVERT_AUTO);
+        TST_SKIP("Kernel not available on this processor");
+    }
+
+    QBENCHMARK {
+        RTeConvert::tripletsToSoA(raw, 8, TST_BENCH_SCANS, false, 4, 0.1, x, y, z);
+    }
+    RTeConvert::setKernel(RTECONVERT_AUTO);
+}
+
+//  mathBatch() compares the SIMD batch operations with the scalar ones for
+//  every length up to a few SIMD widths so that the tail handling is covered
+
+void tst_RTeCore::mathBatch()
+{
+    double worst = 0;
+    double diff;
+
+    for (int count = 0; count < 40; count++) {
+        RTeQuaternionSoA a(count), b(count), result1, result2, norm1(count), norm2(count);
+        RTeVector3SoA vec(count), rotated1, rotated2, vecNorm1(count), vecNorm2(count);
+
+        for (int i = 0; i < count; i++) {
+            RTeQuaternion q(randomFloat(), randomFloat(), randomFloat(), randomFloat());
+
+            q.normalize();
+            a.set(i, q);
+            b.set(i, RTeQuaternion(randomFloat(), randomFloat(), randomFloat(), randomFloat()));
+            vec.set(i, RTeVector3(randomFloat(), randomFloat(), randomFloat()));
+
+            //  include a zero element to check that normalize leaves it alone
+
+            norm1.set(i, i == 3 ? RTeQuaternion() : b.get(i));
+            norm2.set(i, norm1.get(i));
+            vecNorm1.set(i, i == 5 ? RTeVector3() : vec.get(i));
+            vecNorm2.set(i, vecNorm1.get(i));
+        }
+
+        RTeMathBatch::setUseSIMD(false);
+        RTeMathBatch::multiply(a, b, result1);
+        RTeMathBatch::rotate(a, vec, rotated1);
+        RTeMathBatch::normalize(norm1);
+        RTeMathBatch::normalize(vecNorm1);
+        RTeMathBatch::setUseSIMD(true);
+        RTeMathBatch::multiply(a, b, result2);
+        RTeMathBatch::rotate(a, vec, rotated2);
+        RTeMathBatch::normalize(norm2);
+        RTeMathBatch::normalize(vecNorm2);
+
+        QCOMPARE(result2.count(), count);
+        QCOMPARE(rotated2.count(), count);
+
+        for (int i = 0; i < count; i++) {
+            for (int c = 0; c < 4; c++) {
+                if ((diff = fabs(result1.get(i).data(c) - result2.get(i).data(c))) > worst)
+                    worst = diff;
+                if ((diff = fabs(norm1.get(i).data(c) - norm2.get(i).data(c))) > worst)
+                    worst = diff;
+            }
+            for (int c = 0; c < 3; c++) {
+                if ((diff = fabs(rotated1.get(i).data(c) - rotated2.get(i).data(c))) > worst)
+                    worst = diff;
+                if ((diff = fabs(vecNorm1.get(i).data(c) - vecNorm2.get(i).data(c))) > worst)
+                    worst = diff;
+            }
+        }
+    }
+    qDebug("%s largest difference from scalar %g", RTeMathBatch::simdName(), worst);
+    QVERIFY(worst <= TST_BATCH_TOLERANCE);
+}
+
+//  the axis is fixed, with different x, y and z, so that a component taken from
+//  the wrong place always fails and the result doesn't depend on the test order
+
+void tst_RTeCore::mathAngleVector()
+{
+    RTeVector3 axis(1.0, -2.0, 3.0);
+    RTeVector3 result;
+    RTeQuaternion q;
+    RTEFLOAT angle;
+
+    axis.normalize();
+    q.fromAngleVector(1.0, axis);
+    q.toAngleVector(angle, result);
+
+    QVERIFY(fabs(angle - 1.0) < TST_ANGLE_TOLERANCE);
+    for (int c = 0; c < 3; c++)
+        QVERIFY(fabs(result.data(c) - axis.data(c)) < TST_ANGLE_TOLERANCE);
+}
+
+void tst_RTeCore::mathBatchBenchmark_data()
+{
+    QTest::addColumn<bool>("simd");
+
+    QTest::newRow("scalar") << false;
+    QTest::newRow("simd") << true;
+}
+
+void tst_RTeCore::mathBatchBenchmark()
+{
+    QFETCH(bool, simd);
+    RTeQuaternionSoA a(TST_BENCH_ELEMENTS), b(TST_BENCH_ELEMENTS), result;
+    RTeVector3SoA vec(TST_BENCH_ELEMENTS), rotated;
+
+    for (int i = 0; i < TST_BENCH_ELEMENTS; i++) {
+        RTeQuaternion q(randomFloat(), randomFloat(), randomFloat(), randomFloat());
+
+        q.normalize();
+        a.set(i, q);
+        b.set(i, q);
+        vec.set(i, RTeVector3(randomFloat(), randomFloat(), randomFloat()));
+    }
+
+    RTeMathBatch::setUseSIMD(simd);
+    QBENCHMARK {
+        RTeMathBatch::multiply(a, b, result);
+        RTeMathBatch::rotate(a, vec, rotated);
+        RTeMathBatch::normalize(b);
+    }
+    RTeMathBatch::setUseSIMD(true);
+}
+
+QTEST_MAIN(tst_RTeCore)
+
+#include "tst_RTeCore.moc"
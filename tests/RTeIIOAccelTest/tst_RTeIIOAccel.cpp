@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  This file is part of RTembedded
+//
+//  Copyright (c) 2015, richards-tech, LLC
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to use,
+//  copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+//  Software, and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+//  PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+//  Runs RTeIIOAccel against the RTeIIOSim simulated device and checks the
+//  samples that come out of the buffer path.
+
+#include <QtTest/QtTest>
+
+#include "RTeIIOAccel.h"
+#include "RTeIIOSim.h"
+
+#include <qdir.h>
+#include <qelapsedtimer.h>
+#include <unistd.h>
+#include <math.h>
+
+#define TST_SAMPLE_RATE                 "5"                 // RTeIIOAccel rate index for 200Hz
+#define TST_NOMINAL_RATE                200.0
+#define TST_MIN_SAMPLES                 400                 // samples collected before checking
+#define TST_TIMEOUT                     10000               // mS to wait for the samples
+#define TST_RATE_TOLERANCE              0.05                // allowed measured rate error
+
+//  TstAccelReceiver is called directly on the accel module's thread
+
+class TstAccelReceiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    TstAccelReceiver()
+    {
+        m_samples = 0;
+        m_reversals = 0;
+        m_lastTimestamp = 0;
+        m_sumZ = 0;
+    }
+
+    int samples() const { return __atomic_load_n(&m_samples, __ATOMIC_ACQUIRE); }
+
+    //  these are only read once the module has stopped
+
+    int reversals() const { return m_reversals; }
+    qreal meanZ() const { return m_samples > 0 ? m_sumZ / m_samples : 0; }
+
+public slots:
+    void newAccelSampleBatch(RTeModule *, RTeSensorAccelBatch *batch)
+    {
+        for (int i = 0; i < batch->m_count; i++) {
+            if (batch->m_timestampNs[i] <= m_lastTimestamp)
+                m_reversals++;
+            m_lastTimestamp = batch->m_timestampNs[i];
+            m_sumZ += batch->m_z[i];
+        }
+        __atomic_add_fetch(&m_samples, batch->m_count, __ATOMIC_RELEASE);
+    }
+
+private:
+    int m_samples;
+    int m_reversals;
+    qint64 m_lastTimestamp;
+    qreal m_sumZ;
+};
+
+class tst_RTeIIOAccel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void scanLayout();
+
+    void bufferRead_data();
+    void bufferRead();
+
+private:
+    QString m_deviceRoot;
+    int m_run;
+};
+
+void tst_RTeIIOAccel::initTestCase()
+{
+    m_deviceRoot = QDir::tempPath() + QString("/rteiioaccel-test-%1").arg(getpid());
+    m_run = 0;
+}
+
+//  scanLayout() checks the offsets around a repeated channel. The kernel aligns
+//  it to its whole size so the padding moves everything after it as well.
+
+void tst_RTeIIOAccel::scanLayout()
+{
+    RTeIIOScanLayout layout;
+    RTEIIO_CHANNEL channel;
+
+    QVERIFY(RTeIIOScanLayout::parseType("le:s16/16X2>>0", channel));
+    QCOMPARE(channel.m_storageBytes, 2);
+    QCOMPARE(channel.m_repeat, 2);
+    QCOMPARE(RTeIIOScanLayout::typeString(channel), QString("le:s16/16X2>>0"));
+
+    QVERIFY(layout.addChannel("in_accel_x", 0, "le:s16/16>>0"));
+    QVERIFY(layout.addChannel("in_rot_quaternion", 1, "le:s16/16X2>>0"));
+    QVERIFY(layout.addChannel("in_accel_y", 2, "le:s16/16>>0"));
+    QVERIFY(layout.addChannel("in_timestamp", 3, "le:s64/64>>0"));
+
+    QCOMPARE(layout.channel(0).m_offset, 0);
+    QCOMPARE(layout.channel(1).m_offset, 4);
+    QCOMPARE(layout.channel(2).m_offset, 8);
+    QCOMPARE(layout.channel(3).m_offset, 16);
+    QCOMPARE(layout.scanSize(), 24);
+}
+
+void tst_RTeIIOAccel::bufferRead_data()
+{
+    QTest::addColumn<bool>("usePoll");
+    QTest::addColumn<bool>("gaps");
+
+    QTest::newRow("poll") << true << false;
+    QTest::newRow("timer") << false << false;
+    QTest::newRow("poll with gaps") << true << true;
+}
+
+//  bufferRead() collects samples through the buffer and checks their
+//  timestamps, the gap detection and the measured rate
+
+void tst_RTeIIOAccel::bufferRead()
+{
+    QFETCH(bool, usePoll);
+    QFETCH(bool, gaps);
+    TstAccelReceiver receiver;
+    RTEIIO_SAMPLE_STATS stats;
+    QElapsedTimer elapsed;
+    qreal measuredRate;
+
+    //  each run gets its own device so that nothing is left over from the last one
+
+    QString root = m_deviceRoot + QString("/%1").arg(m_run++);
+
+    RTeIIOSim *sim = new RTeIIOSim();
+    sim->setModuleName("sim");
+    sim->setDeviceRoot(root);
+    sim->setSeed("1");
+    sim->setGapRate(gaps ? "0.01" : "0");
+    sim->resumeThread();
+
+    RTeIIOAccel *accel = new RTeIIOAccel();
+    accel->setModuleName("accel");
+    accel->setDeviceRoot(root);
+    accel->setSampleRate(TST_SAMPLE_RATE);
+    accel->setUsePoll(usePoll ? "true" : "false");
+    connect(accel, SIGNAL(newAccelSampleBatch(RTeModule *,RTeSensorAccelBatch *)),
+            &receiver, SLOT(newAccelSampleBatch(RTeModule *,RTeSensorAccelBatch *)), Qt::DirectConnection);
+    accel->resumeThread();
+
+    elapsed.start();
+    while ((receiver.samples() < TST_MIN_SAMPLES) && (elapsed.elapsed() < TST_TIMEOUT))
+        QTest::qWait(50);
+
+    stats = accel->getSampleStats();
+    measuredRate = accel->getMeasuredRate();
+
+    //  the modules delete themselves once their threads have finished
+
+    accel->exitThread();
+    sim->exitThread();
+    QTest::qWait(200);
+
+    QVERIFY(receiver.samples() >= TST_MIN_SAMPLES);
+    QCOMPARE(receiver.reversals(), 0);
+    QVERIFY(fabs(receiver.meanZ() - 1.0) < 0.1);
+    QCOMPARE(stats.m_reversals, (qint64)0);
+    QCOMPARE(stats.m_duplicates, (qint64)0);
+
+    if (gaps) {
+        QVERIFY(stats.m_gaps > 0);
+        QVERIFY(stats.m_lostSamples >= stats.m_gaps);
+    } else {
+        QCOMPARE(stats.m_gaps, (qint64)0);
+    }
+
+    //  lost samples are accounted for so the rate should be right either way
+
+    QVERIFY(fabs(measuredRate / TST_NOMINAL_RATE - 1.0) < TST_RATE_TOLERANCE);
+}
+
+QTEST_MAIN(tst_RTeIIOAccel)
+
+#include "tst_RTeIIOAccel.moc"